@@ -46,7 +46,62 @@
 /**************************************************************************/
 
 #include "Adafruit_TSL2591.h"
+#include <stddef.h>
 #include <stdlib.h>
+#include <new>
+
+/// The flag this file was built with, see TSL2591_STATS_CHECK
+const uint8_t TSL2591_STATS_CHECK = TSL2591_ENABLE_STATS;
+
+/// Analog gain multiplier for each tsl2591Gain_t (indexed by gain >> 4)
+static const uint16_t tsl2591GainScale[4] = {1, 25, 428, 9876};
+
+/// One row of tsl2591LuxTable, the lux factor for each integration time
+#define TSL2591_LUX_ROW(gain)                                                  \
+  {                                                                            \
+    Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_100MS),          \
+        Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_200MS),      \
+        Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_300MS),      \
+        Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_400MS),      \
+        Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_500MS),      \
+        Adafruit_TSL2591::luxFactor(gain, TSL2591_INTEGRATIONTIME_600MS),      \
+  }
+
+/// Lux reciprocal table, indexed by [gain >> 4][integration]
+static const uint32_t tsl2591LuxTable[4][6] PROGMEM = {
+    TSL2591_LUX_ROW(TSL2591_GAIN_LOW),
+    TSL2591_LUX_ROW(TSL2591_GAIN_MED),
+    TSL2591_LUX_ROW(TSL2591_GAIN_HIGH),
+    TSL2591_LUX_ROW(TSL2591_GAIN_MAX),
+};
+
+/**************************************************************************/
+/*!
+    @brief  Relative sensitivity of a gain/integration setting, in units of
+   low gain at 100ms
+*/
+/**************************************************************************/
+static uint16_t tsl2591Sensitivity(tsl2591Gain_t gain,
+                                   tsl2591IntegrationTime_t integration) {
+  return tsl2591GainScale[gain >> 4] * (integration + 1);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checksums a saved driver state, so a blob that retained memory
+   lost (or never held) is rejected
+    @param  state State to checksum
+    @returns Checksum over every field before check
+*/
+/**************************************************************************/
+static uint8_t tsl2591StateCheck(const tsl2591State_t *state) {
+  const uint8_t *bytes = (const uint8_t *)state;
+  uint8_t check = 0xA5; // so all zero memory does not pass
+  for (size_t i = 0; i < offsetof(tsl2591State_t, check); i++) {
+    check = (uint8_t)((check << 1) | (check >> 7)) ^ bytes[i];
+  }
+  return check;
+}
 
 /**************************************************************************/
 /*!
@@ -60,15 +115,47 @@ Adafruit_TSL2591::Adafruit_TSL2591(int32_t sensorID) {
   _integration = TSL2591_INTEGRATIONTIME_100MS;
   _gain = TSL2591_GAIN_MED;
   _sensorID = sensorID;
+  _conversionStart = 0;
+  _sequence = 0;
+  _continuousPersist = TSL2591_PERSIST_EVERY;
+  _continuous = false;
+  _regsValid = 0;
+  _autoRangeLow = TSL2591_AUTORANGE_LOW;
+  _autoRangeHigh = TSL2591_AUTORANGE_HIGH;
+  memset(&_autoRange, 0, sizeof(_autoRange));
+  _settlePolicy = TSL2591_SETTLE_DOUBLE;
+  _settleThreshold = TSL2591_SETTLE_THRESHOLD;
+  _lastLum = 0;
+  _lastControl = 0xFF;
+  _busMonitor = NULL;
+  _busMonitorContext = NULL;
+  _samples = NULL;
+  _queue = NULL;
+  _interruptsRaised = 0;
+  _interruptsServiced = 0;
+  _trackingPercent = 0;
+  _trackingPersist = TSL2591_PERSIST_ANY;
+  memset(_trackingSaved, 0, sizeof(_trackingSaved));
+  _luxCalibration = 65536;
+  _luxK = 0;
+  _luxControl = 0xFF;
+  memset(&_accum, 0, sizeof(_accum));
+  _decimation = 0;
+  _retries = TSL2591_RETRIES;
+  _retryBackoffUs = TSL2591_RETRY_BACKOFF_US;
+  _retryDeadlineMs = TSL2591_RETRY_DEADLINE_MS;
+  _consecutiveErrors = 0;
+  _busError = false;
+  _verifyPending = false;
+#if TSL2591_ENABLE_STATS
+  memset(&_stats, 0, sizeof(_stats));
+#endif
 
   // we cant do wire initialization till later, because we havent loaded Wire
   // yet
 }
 
-Adafruit_TSL2591::~Adafruit_TSL2591() {
-  if (i2c_dev)
-    delete i2c_dev;
-}
+Adafruit_TSL2591::~Adafruit_TSL2591() { releaseI2CDevice(); }
 
 /**************************************************************************/
 /*!
@@ -79,46 +166,250 @@ Adafruit_TSL2591::~Adafruit_TSL2591() {
 */
 /**************************************************************************/
 boolean Adafruit_TSL2591::begin(TwoWire *theWire, uint8_t addr) {
-  if (i2c_dev)
-    delete i2c_dev;
-  i2c_dev = new Adafruit_I2CDevice(addr, theWire);
-  if (!i2c_dev->begin())
-    return false;
+  attach(theWire, addr);
+  return probe();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Setups the I2C interface and loads a complete configuration into
+   the chip. The ID check also reads back what the chip holds, so only the
+   settings that differ are written: after power up that is typically one
+   read and one or two writes in total.
+    @param   config Gain, timing, interrupt windows and power state to apply
+    @param   theWire a reference to TwoWire instance
+    @param   addr The I2C adress of the sensor (Default 0x29)
+    @returns True if a TSL2591 is found, false on any failure
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::begin(const tsl2591Config_t *config,
+                                TwoWire *theWire, uint8_t addr) {
+  attach(theWire, addr);
+  return probe(config);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Setups the hardware on a bus device owned by the caller, which
+   must outlive this object. Nothing is allocated.
+    @param   device The I2C device the sensor is reachable through
+    @returns True if a TSL2591 is found, false on any failure
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::begin(Adafruit_I2CDevice *device) {
+  if (device != i2c_dev) {
+    releaseI2CDevice();
+    i2c_dev = device;
+  }
+  _ownsI2cDev = false;
+  return probe();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Setups the I2C interface and hardware, identifies if chip is found
+    @param   addr The I2C adress of the sensor (Default 0x29)
+    @returns True if a TSL2591 is found, false on any failure
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::begin(uint8_t addr) {
+  // Keep using a device the caller handed us, e.g. when a method retries
+  // begin() after a failed probe
+  if (i2c_dev && !_ownsI2cDev && i2c_dev->address() == addr) {
+    return probe();
+  }
+  return begin(&Wire, addr);
+}
 
-  /*
-  for (uint8_t i=0; i<0x20; i++)
-  {
-    uint8_t id = read8(0x12);
-    Serial.print("$"); Serial.print(i, HEX);
-    Serial.print(" = 0x"); Serial.println(read8(i), HEX);
+/**************************************************************************/
+/*!
+    @brief   Picks up where exportState() left off, e.g. after the MCU woke
+   from deep sleep while the sensor stayed powered. The saved state is
+   trusted: there is no ID check and nothing is rewritten, a conversion is
+   started right away (in continuous mode the ADC kept running, so a reading
+   is available at once). That is a single one byte write before the first
+   sample, against a read and several writes for begin().
+    @param   state State saved by exportState()
+    @param   theWire a reference to TwoWire instance
+    @param   verify Check the chip in the first readResult(), which then
+   reads every register in its one transaction. If the chip was reset or
+   replaced meanwhile, the settings are restored and the reading fails with
+   TSL2591_ERR_RESET (or the ALS is powered down and it fails with
+   TSL2591_ERR_NOT_FOUND).
+    @returns True if the state was loaded and the conversion started, false
+   if the state is invalid or the bus failed; call begin() then
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::resume(const tsl2591State_t *state,
+                                 TwoWire *theWire, bool verify) {
+  if ((state->version != TSL2591_STATE_VERSION) ||
+      (state->check != tsl2591StateCheck(state))) {
+    return false;
   }
-  */
 
-  uint8_t id = read8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_ID);
-  if (id != 0x50) {
+  _initialized = false;
+  attach(theWire, state->address);
+  // Skip the address probe, the first transaction fails anyway if the chip
+  // is gone
+  if (!i2c_dev->begin(false)) {
     return false;
   }
-  // Serial.println("Found Adafruit_TSL2591");
 
+  memcpy(_regs, state->regs, sizeof(_regs));
+  _regsValid = (1 << sizeof(_regs)) - 1;
+  _gain = (tsl2591Gain_t)(_regs[TSL2591_REGISTER_CONTROL] & 0x30);
+  _integration =
+      (tsl2591IntegrationTime_t)(_regs[TSL2591_REGISTER_CONTROL] & 0x07);
+  _luxCalibration = state->luxCalibration;
+  _luxControl = 0xFF;
+  _continuous = state->continuous;
+  _verifyPending = verify;
+  _busError = false;
   _initialized = true;
 
-  // Set default integration time and gain
-  setTiming(_integration);
-  setGain(_gain);
+  if (_continuous) {
+    // The ADC kept running. Whether a conversion is new is up to the ALS
+    // interrupt flag, which the chip kept too
+    _sequence = 0;
+    _continuousPersist = _regs[TSL2591_REGISTER_PERSIST_FILTER];
+  } else {
+    startConversion();
+  }
+  return !_busError;
+}
 
-  // Note: by default, the device is in power down mode on bootup
-  disable();
+/**************************************************************************/
+/*!
+    @brief   Saves what resume() needs to carry on without begin(): the bus
+   address, gain, timing, interrupt thresholds, power mode and lux
+   calibration. Callbacks, queues and sample buffers are not saved.
+    @param   state Filled in with the driver state, zeroed on failure
+    @returns True if saved, false if the driver does not know what the chip
+   holds (not initialized, or a write failed since)
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::exportState(tsl2591State_t *state) {
+  memset(state, 0, sizeof(*state));
+  if (!_initialized || !i2c_dev ||
+      (_regsValid != (1 << sizeof(_regs)) - 1)) {
+    return false;
+  }
 
+  state->luxCalibration = _luxCalibration;
+  state->version = TSL2591_STATE_VERSION;
+  state->address = i2c_dev->address();
+  state->continuous = _continuous;
+  memcpy(state->regs, _regs, sizeof(state->regs));
+  state->check = tsl2591StateCheck(state);
   return true;
 }
+
 /**************************************************************************/
 /*!
-    @brief   Setups the I2C interface and hardware, identifies if chip is found
-    @param   addr The I2C adress of the sensor (Default 0x29)
+    @brief   Creates the bus device for begin(). It is only created on the
+   first call (or when the bus or address changes), so calling begin() again
+   after a bus reset does not allocate. It is built in place inside this
+   object, the heap is never used.
+    @param   theWire a reference to TwoWire instance
+    @param   addr The I2C adress of the sensor
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::attach(TwoWire *theWire, uint8_t addr) {
+  if (i2c_dev && _ownsI2cDev && _wire == theWire &&
+      i2c_dev->address() == addr) {
+    return;
+  }
+
+  releaseI2CDevice();
+  i2c_dev = new (_i2cStorage) Adafruit_I2CDevice(addr, theWire);
+  _ownsI2cDev = true;
+  _wire = theWire;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Destroys the bus device if begin() created it, and forgets it
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::releaseI2CDevice(void) {
+  if (i2c_dev && _ownsI2cDev) {
+    i2c_dev->~Adafruit_I2CDevice();
+  }
+  i2c_dev = NULL;
+  _ownsI2cDev = false;
+  _wire = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Identifies the chip on i2c_dev and loads our settings into it
+    @param   config Configuration to apply, or NULL for the current gain and
+   timing with the ALS powered down
     @returns True if a TSL2591 is found, false on any failure
 */
 /**************************************************************************/
-boolean Adafruit_TSL2591::begin(uint8_t addr) { return begin(&Wire, addr); }
+boolean Adafruit_TSL2591::probe(const tsl2591Config_t *config) {
+  _initialized = false;
+  _verifyPending = false;
+  // Whatever mode we were in, the chip may have been power cycled out of
+  // it. Forget it before anything is programmed, so the persist filter is
+  // written as asked rather than kept for continuous mode.
+  _continuous = false;
+  _sequence = 0;
+  _continuousPersist = TSL2591_PERSIST_EVERY;
+  uint32_t start = _busMonitor ? micros() : 0;
+  bool found = i2c_dev->begin();
+  recordTransaction(start, TSL2591_ADDRESS_PROBE, 0, 0, found);
+  if (!found)
+    return false;
+
+  // The chip may have been power cycled, so nothing we cached can be
+  // trusted. One read of ENABLE..ID both identifies the chip and reseeds the
+  // shadow cache, so only settings that differ are written below.
+  uint8_t regs[TSL2591_REGISTER_DEVICE_ID + 1];
+  memset(regs, 0, sizeof(regs));
+  readBlock(TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE, regs, sizeof(regs));
+  if (regs[TSL2591_REGISTER_DEVICE_ID] != 0x50) {
+    _regsValid = 0;
+    return false;
+  }
+  // Serial.println("Found Adafruit_TSL2591");
+
+  memcpy(_regs, regs, sizeof(_regs));
+  _regsValid = (1 << sizeof(_regs)) - 1;
+  _initialized = true;
+
+  if (!config) {
+    // Set default integration time and gain
+    setControl(_gain, _integration);
+
+    // Note: by default, the device is in power down mode on bootup
+    disable();
+
+    return true;
+  }
+
+  registerInterrupt(config->lowerThreshold, config->upperThreshold,
+                    config->npLowerThreshold, config->npUpperThreshold,
+                    config->persist);
+  _gain = config->gain;
+  _integration = config->integration;
+
+  if (config->power == TSL2591_POWER_CONTINUOUS) {
+    // Settings first, so the first conversion already uses them
+    updateRegister(TSL2591_REGISTER_CONTROL, _integration | _gain);
+    startContinuous();
+  } else {
+    // ENABLE and CONTROL are adjacent, power down and set up in one write
+    uint8_t buffer[2];
+    buffer[0] = TSL2591_ENABLE_POWEROFF;
+    buffer[1] = _integration | _gain;
+    _continuous = false;
+    updateRegisters(TSL2591_REGISTER_ENABLE, buffer, 2);
+  }
+
+  return true;
+}
 
 /**************************************************************************/
 /*!
@@ -133,14 +424,17 @@ void Adafruit_TSL2591::enable(void) {
   }
 
   // Enable the device by setting the control bit to 0x01
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE,
-         TSL2591_ENABLE_POWERON | TSL2591_ENABLE_AEN | TSL2591_ENABLE_AIEN |
-             TSL2591_ENABLE_NPIEN);
+  if (updateRegister(TSL2591_REGISTER_ENABLE,
+                     TSL2591_ENABLE_POWERON | TSL2591_ENABLE_AEN |
+                         TSL2591_ENABLE_AIEN | TSL2591_ENABLE_NPIEN)) {
+    _conversionStart = millis();
+  }
 }
 
 /**************************************************************************/
 /*!
-    @brief Disables the chip, so it's in power down mode
+    @brief Disables the chip, so it's in power down mode. Continuous mode and
+   tracking stop, and the settings they took over are put back.
 */
 /**************************************************************************/
 void Adafruit_TSL2591::disable(void) {
@@ -150,9 +444,19 @@ void Adafruit_TSL2591::disable(void) {
     }
   }
 
+  if (_trackingPercent) {
+    // Put back the thresholds and persist filter tracking took over
+    _trackingPercent = 0;
+    updateRegisters(TSL2591_REGISTER_THRESHOLD_AILTL, _trackingSaved,
+                    sizeof(_trackingSaved));
+  } else if (_continuous) {
+    // Put back the persist filter startContinuous() took over
+    updateRegister(TSL2591_REGISTER_PERSIST_FILTER, _continuousPersist);
+  }
+  _continuous = false;
+
   // Disable the device by setting the control bit to 0x00
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE,
-         TSL2591_ENABLE_POWEROFF);
+  updateRegister(TSL2591_REGISTER_ENABLE, TSL2591_ENABLE_POWEROFF);
 }
 
 /************************************************************************/
@@ -168,10 +472,7 @@ void Adafruit_TSL2591::setGain(tsl2591Gain_t gain) {
     }
   }
 
-  enable();
-  _gain = gain;
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_CONTROL, _integration | _gain);
-  disable();
+  setControl(gain, _integration);
 }
 
 /************************************************************************/
@@ -195,10 +496,7 @@ void Adafruit_TSL2591::setTiming(tsl2591IntegrationTime_t integration) {
     }
   }
 
-  enable();
-  _integration = integration;
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_CONTROL, _integration | _gain);
-  disable();
+  setControl(_gain, integration);
 }
 
 /************************************************************************/
@@ -211,299 +509,1902 @@ tsl2591IntegrationTime_t Adafruit_TSL2591::getTiming() { return _integration; }
 
 /************************************************************************/
 /*!
-    @brief  Calculates the visible Lux based on the two light sensors
-    @param  ch0 Data from channel 0 (IR+Visible)
-    @param  ch1 Data from channel 1 (IR)
-    @returns Lux, based on AMS coefficients (or < 0 if overflow)
+    @brief  Sets gain and integration time together, in one CONTROL write
+   and only if either changed
+    @param  gain {@link tsl2591Gain_t} gain value
+    @param  integration {@link tsl2591IntegrationTime_t} integration time
 */
 /**************************************************************************/
-float Adafruit_TSL2591::calculateLux(uint16_t ch0, uint16_t ch1) {
-  float atime, again;
-  float cpl, lux;
-
-  // Check for overflow conditions first
-  if ((ch0 == 0xFFFF) | (ch1 == 0xFFFF)) {
-    // Signal an overflow
-    return -1;
+void Adafruit_TSL2591::setControl(tsl2591Gain_t gain,
+                                  tsl2591IntegrationTime_t integration) {
+  bool restart =
+      _continuous && ((gain != _gain) || (integration != _integration));
+  _gain = gain;
+  _integration = integration;
+  if (restart) {
+    // The cycle in flight would complete with the old settings, so stop
+    // the ADC and drop its flag; AVALID then waits for the new settings
+    updateRegister(TSL2591_REGISTER_ENABLE,
+                   _regs[TSL2591_REGISTER_ENABLE] & ~TSL2591_ENABLE_AEN);
   }
+  updateRegister(TSL2591_REGISTER_CONTROL, _integration | _gain);
+  if (restart) {
+    write8(TSL2591_CLEAR_ALS_INT);
+    enable();
+  }
+}
 
-  // Note: This algorithm is based on preliminary coefficients
-  // provided by AMS and may need to be updated in the future
-
-  switch (_integration) {
-  case TSL2591_INTEGRATIONTIME_100MS:
-    atime = 100.0F;
-    break;
-  case TSL2591_INTEGRATIONTIME_200MS:
-    atime = 200.0F;
-    break;
-  case TSL2591_INTEGRATIONTIME_300MS:
-    atime = 300.0F;
-    break;
-  case TSL2591_INTEGRATIONTIME_400MS:
-    atime = 400.0F;
-    break;
-  case TSL2591_INTEGRATIONTIME_500MS:
-    atime = 500.0F;
-    break;
-  case TSL2591_INTEGRATIONTIME_600MS:
-    atime = 600.0F;
-    break;
-  default: // 100ms
-    atime = 100.0F;
-    break;
-  }
-
-  switch (_gain) {
-  case TSL2591_GAIN_LOW:
-    again = 1.0F;
-    break;
-  case TSL2591_GAIN_MED:
-    again = 25.0F;
-    break;
-  case TSL2591_GAIN_HIGH:
-    again = 428.0F;
-    break;
-  case TSL2591_GAIN_MAX:
-    again = 9876.0F;
-    break;
-  default:
-    again = 1.0F;
-    break;
-  }
-
-  // cpl = (ATIME * AGAIN) / DF
-  cpl = (atime * again) / TSL2591_LUX_DF;
-
-  // Original lux calculation (for reference sake)
-  // float lux1 = ( (float)ch0 - (TSL2591_LUX_COEFB * (float)ch1) ) / cpl;
-  // float lux2 = ( ( TSL2591_LUX_COEFC * (float)ch0 ) - ( TSL2591_LUX_COEFD *
-  // (float)ch1 ) ) / cpl; lux = lux1 > lux2 ? lux1 : lux2;
-
-  // Alternate lux calculation 1
-  // See: https://github.com/adafruit/Adafruit_TSL2591_Library/issues/14
-  lux = (((float)ch0 - (float)ch1)) * (1.0F - ((float)ch1 / (float)ch0)) / cpl;
-
-  // Alternate lux calculation 2
-  // lux = ( (float)ch0 - ( 1.7F * (float)ch1 ) ) / cpl;
-
-  // Signal I2C had no errors
-  return lux;
+/************************************************************************/
+/*!
+    @brief  Sets the CH0 hysteresis band used by the auto-range engine.
+   Settings are only changed when a reading falls outside the band, and the
+   band should span more than the largest sensitivity step (~4.2x) so there
+   is always a setting that lands inside it.
+    @param  low Readings below this many counts increase sensitivity
+    @param  high Readings above this many counts decrease sensitivity
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::setAutoRangeBand(uint16_t low, uint16_t high) {
+  _autoRangeLow = low;
+  _autoRangeHigh = high;
 }
 
 /************************************************************************/
 /*!
-    @brief  Reads the raw data from both light channels
-    @returns 32-bit raw count where high word is IR, low word is IR+Visible
+    @brief  Picks the gain/integration for the next conversion from a CH0
+   reading taken with the current settings. Rather than stepping through the
+   settings one at a time, the reading is scaled to every setting and the one
+   predicted to land inside the band with the shortest integration time is
+   applied directly (or the closest one below the top of the band).
+    @param  ch0 CH0 (IR+Visible) counts read with the current settings
+    @returns True if the settings were changed
 */
 /**************************************************************************/
-uint32_t Adafruit_TSL2591::getFullLuminosity(void) {
+bool Adafruit_TSL2591::autoRange(uint16_t ch0) {
   if (!_initialized) {
     if (!begin()) {
-      return 0;
+      return false;
     }
   }
 
-  // Enable the device
-  enable();
+  tsl2591Gain_t gain = _gain;
+  tsl2591IntegrationTime_t integration = _integration;
+  uint32_t predicted = ch0;
+  tsl2591AutoRangeAction_t action = TSL2591_AUTORANGE_HOLD;
+
+  if (ch0 >= saturationLimit(_integration)) {
+    // The reading is clipped, so the real level is unknown and scaling it
+    // would undershoot. Jump straight to the one setting that cannot
+    // saturate below full scale and let the next reading pick the final
+    // setting, instead of stepping down one conversion at a time.
+    gain = TSL2591_GAIN_LOW;
+    integration = TSL2591_INTEGRATIONTIME_100MS;
+    action = TSL2591_AUTORANGE_SATURATED;
+  } else if ((ch0 < _autoRangeLow) || (ch0 > _autoRangeHigh)) {
+    uint32_t current = tsl2591Sensitivity(_gain, _integration);
+    uint32_t counts = ch0 ? ch0 : 1;
+    bool inBand = false;
+
+    gain = TSL2591_GAIN_LOW;
+    integration = TSL2591_INTEGRATIONTIME_100MS;
+    predicted = counts / current;
+    for (uint8_t g = 0; g < 4; g++) {
+      for (uint8_t t = 0; t <= TSL2591_INTEGRATIONTIME_600MS; t++) {
+        tsl2591Gain_t cg = (tsl2591Gain_t)(g << 4);
+        tsl2591IntegrationTime_t ct = (tsl2591IntegrationTime_t)t;
+        uint32_t p = counts * tsl2591Sensitivity(cg, ct) / current;
+        if (p > _autoRangeHigh) {
+          continue;
+        }
+        bool in = p >= _autoRangeLow;
+        bool better;
+        if (in) {
+          better = !inBand || (ct < integration) ||
+                   ((ct == integration) && (p > predicted));
+        } else {
+          better = !inBand && (p > predicted);
+        }
+        if (better) {
+          gain = cg;
+          integration = ct;
+          predicted = p;
+          inBand = in;
+        }
+      }
+    }
 
-  // Wait x ms for ADC to complete
-  for (uint8_t d = 0; d <= _integration; d++) {
-    delay(120);
+    uint32_t next = tsl2591Sensitivity(gain, integration);
+    if (next > current) {
+      action = TSL2591_AUTORANGE_UP;
+    } else if (next < current) {
+      action = TSL2591_AUTORANGE_DOWN;
+    }
   }
 
-  // CHAN0 must be read before CHAN1
-  // See: https://forums.adafruit.com/viewtopic.php?f=19&t=124176
-  uint32_t x;
-  uint16_t y;
-  y = read16(TSL2591_COMMAND_BIT | TSL2591_REGISTER_CHAN0_LOW);
-  x = read16(TSL2591_COMMAND_BIT | TSL2591_REGISTER_CHAN1_LOW);
-  x <<= 16;
-  x |= y;
+  bool changed = (gain != _gain) || (integration != _integration);
 
-  disable();
+  _autoRange.ch0 = ch0;
+  _autoRange.predicted = predicted;
+  _autoRange.gain = gain;
+  _autoRange.integration = integration;
+  _autoRange.action = action;
 
-  return x;
+  setControl(gain, integration);
+
+  return changed;
 }
 
 /************************************************************************/
 /*!
-    @brief  Reads the raw data from the channel
-    @param  channel Can be 0 (IR+Visible, 1 (IR) or 2 (Visible only)
-    @returns 16-bit raw count, or 0 if channel is invalid
+    @brief  Takes readings, re-ranging in between, until CH0 lands inside the
+   auto-range band or maxConversions readings have been taken. The settings
+   after the call are the ones the returned reading was taken with, so it can
+   be passed straight to calculateLux(). A reading that failed (see
+   readFullLuminosity()) ends the loop without changing the settings.
+    @param  maxConversions Upper bound on the number of conversions
+    @returns 32-bit raw count where high word is IR, low word is IR+Visible,
+   or 0 on a bus error
 */
 /**************************************************************************/
-uint16_t Adafruit_TSL2591::getLuminosity(uint8_t channel) {
-  uint32_t x = getFullLuminosity();
-
-  if (channel == TSL2591_FULLSPECTRUM) {
-    // Reads two byte value from channel 0 (visible + infrared)
-    return (x & 0xFFFF);
-  } else if (channel == TSL2591_INFRARED) {
-    // Reads two byte value from channel 1 (infrared)
-    return (x >> 16);
-  } else if (channel == TSL2591_VISIBLE) {
-    // Reads all and subtracts out just the visible!
-    return ((x & 0xFFFF) - (x >> 16));
+uint32_t Adafruit_TSL2591::getAutoRangedLuminosity(uint8_t maxConversions) {
+  uint32_t x = 0;
+  uint8_t n = 0;
+
+  while (n < maxConversions) {
+    tsl2591Result_t result = readFullLuminosity(&x);
+    n++;
+    if ((result != TSL2591_OK) && (result != TSL2591_ERR_SATURATED)) {
+      // No reading at the current settings to range from
+      break;
+    }
+    if (n == maxConversions) {
+      break;
+    }
+    if (!autoRange(x & 0xFFFF)) {
+      break;
+    }
   }
 
-  // unknown channel!
-  return 0;
+  _autoRange.conversions = n;
+  return x;
 }
 
 /************************************************************************/
 /*!
-    @brief  Set up the interrupt to go off when light level is outside the
-   lower/upper range.
-    @param  lowerThreshold Raw light data reading level that is the lower value
-   threshold for interrupt
-    @param  upperThreshold Raw light data reading level that is the higher value
-   threshold for interrupt
-    @param  persist How many counts we must be outside range for interrupt to
-   fire, default is any single value
+    @brief  Gets the last decision made by the auto-range engine
+    @param  decision Pointer to a tsl2591AutoRange_t that will be filled in
 */
 /**************************************************************************/
-void Adafruit_TSL2591::registerInterrupt(
-    uint16_t lowerThreshold, uint16_t upperThreshold,
-    tsl2591Persist_t persist = TSL2591_PERSIST_ANY) {
-  if (!_initialized) {
-    if (!begin()) {
-      return;
-    }
-  }
-
-  enable();
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_PERSIST_FILTER, persist);
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_THRESHOLD_AILTL,
-         lowerThreshold);
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_THRESHOLD_AILTH,
-         lowerThreshold >> 8);
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_THRESHOLD_AIHTL,
-         upperThreshold);
-  write8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_THRESHOLD_AIHTH,
-         upperThreshold >> 8);
-  disable();
+void Adafruit_TSL2591::getAutoRangeDecision(tsl2591AutoRange_t *decision) {
+  *decision = _autoRange;
 }
 
 /************************************************************************/
 /*!
-    @brief  Clear interrupt status
+    @brief  Calculates the visible Lux based on the two light sensors
+    @param  ch0 Data from channel 0 (IR+Visible)
+    @param  ch1 Data from channel 1 (IR)
+    @returns Lux, based on AMS coefficients (or < 0 if saturated). It is
+   scaled from the same fixed point result as calculateLuxMilli() but not
+   rounded to milli-lux, so low light keeps the sensor's resolution (about
+   0.07 milli-lux per count at max gain and 600ms). The relative error
+   against the exact formula is within 0.012% at max gain and 600ms, where
+   the Q16 lux factor has the fewest significant bits, and less at lower
+   gains. On top of that comes one 2^-16 count LSB of the fixed point
+   counts, and for AMS and ALT2 their Q16 coefficient rounding, below 2^-16
+   counts per count of CH1.
 */
 /**************************************************************************/
-void Adafruit_TSL2591::clearInterrupt() {
-  if (!_initialized) {
-    if (!begin()) {
-      return;
-    }
+float Adafruit_TSL2591::calculateLux(uint16_t ch0, uint16_t ch1) {
+  uint16_t limit = saturationLimit(_integration);
+  if ((ch0 >= limit) || (ch1 >= limit)) {
+    // Signal an overflow
+    TSL2591_STAT(_stats.overflows++);
+    return -1;
   }
 
-  enable();
-  write8(TSL2591_CLEAR_INT);
-  disable();
+  return tsl2591LuxFloat(luxFormula(ch0, ch1, 1), luxK());
 }
 
 /************************************************************************/
 /*!
-    @brief  Gets the most recent sensor event from the hardware status register.
-    @return Sensor status as a byte. Bit 0 is ALS Valid. Bit 4 is ALS Interrupt.
-   Bit 5 is No-persist Interrupt.
+    @brief  Calculates the visible Lux with integer math only, using the
+   current gain and integration time
+    @param  ch0 Data from channel 0 (IR+Visible)
+    @param  ch1 Data from channel 1 (IR)
+    @returns Milli-lux, or -1 on overflow
 */
 /**************************************************************************/
-uint8_t Adafruit_TSL2591::getStatus(void) {
-  if (!_initialized) {
-    if (!begin()) {
-      return 0;
+int32_t Adafruit_TSL2591::calculateLuxMilli(uint16_t ch0, uint16_t ch1) {
+  uint16_t limit = saturationLimit(_integration);
+  int32_t mlux = ((ch0 >= limit) || (ch1 >= limit))
+                     ? -1
+                     : calculateLuxMilli(ch0, ch1, luxK());
+  TSL2591_STAT(_stats.overflows += (mlux < 0));
+  return mlux;
+}
+
+/************************************************************************/
+/*!
+    @brief  Getter for the calibrated lux factor of the current settings,
+   refreshed only when the settings or the calibration changed
+    @returns luxFactor() times the calibration
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591::luxK(void) {
+  uint8_t control = _integration | _gain;
+  if (control != _luxControl) {
+    // Settings changed, refresh the calibrated factor once for all samples
+    tsl2591IntegrationTime_t integration = _integration;
+    if (integration > TSL2591_INTEGRATIONTIME_600MS) {
+      integration = TSL2591_INTEGRATIONTIME_100MS;
     }
+    _luxK = tsl2591Calibrate(
+        pgm_read_dword(&tsl2591LuxTable[(_gain >> 4) & 3][integration]),
+        _luxCalibration);
+    _luxControl = control;
   }
-
-  // Enable the device
-  enable();
-  uint8_t x;
-  x = read8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS);
-  disable();
-  return x;
+  return _luxK;
 }
 
 /************************************************************************/
 /*!
-    @brief  Gets the most recent sensor event
-    @param  event Pointer to Adafruit_Sensor sensors_event_t object that will be
-   filled with sensor data
-    @return True on success, False on failure
+    @brief  Sets a per-device calibration factor that every lux value from
+   this object is multiplied by, e.g. the attenuation of the glass in front
+   of the sensor. It is folded into the lux factor when the settings change,
+   so calibrated readings cost nothing extra.
+    @param  factor Scale factor, 1.0 for none
 */
 /**************************************************************************/
-bool Adafruit_TSL2591::getEvent(sensors_event_t *event) {
-  uint16_t ir, full;
-  uint32_t lum = getFullLuminosity();
-  /* Early silicon seems to have issues when there is a sudden jump in */
-  /* light levels. :( To work around this for now sample the sensor 2x */
-  lum = getFullLuminosity();
-  ir = lum >> 16;
-  full = lum & 0xFFFF;
+void Adafruit_TSL2591::setLuxCalibration(float factor) {
+  _luxCalibration = tsl2591CalibrationQ16(factor);
+  _luxControl = 0xFF;
+}
 
-  /* Clear the event */
-  memset(event, 0, sizeof(sensors_event_t));
+/************************************************************************/
+/*!
+    @brief  Getter for the calibration factor
+    @returns Scale factor set by setLuxCalibration(), 1.0 by default
+*/
+/**************************************************************************/
+float Adafruit_TSL2591::getLuxCalibration(void) {
+  return _luxCalibration / 65536.0F;
+}
 
-  event->version = sizeof(sensors_event_t);
-  event->sensor_id = _sensorID;
-  event->type = SENSOR_TYPE_LIGHT;
-  event->timestamp = millis();
+/************************************************************************/
+/*!
+    @brief  Calculates the visible Lux with integer math only, for data taken
+   with the given settings. Readings at the analog count limit for the
+   integration time count as overflow too, see saturationLimit(). See
+   calculateLuxMilli(ch0, ch1, k) for the accuracy bound.
+    @param  ch0 Data from channel 0 (IR+Visible)
+    @param  ch1 Data from channel 1 (IR)
+    @param  gain {@link tsl2591Gain_t} gain the data was taken with
+    @param  integration {@link tsl2591IntegrationTime_t} integration time the
+   data was taken with
+    @returns Milli-lux, or -1 on overflow
+*/
+/**************************************************************************/
+int32_t
+Adafruit_TSL2591::calculateLuxMilli(uint16_t ch0, uint16_t ch1,
+                                    tsl2591Gain_t gain,
+                                    tsl2591IntegrationTime_t integration) {
+  if (integration > TSL2591_INTEGRATIONTIME_600MS) {
+    integration = TSL2591_INTEGRATIONTIME_100MS;
+  }
 
-  /* Calculate the actual lux value */
-  /* 0 = sensor overflow (too much light) */
-  event->light = calculateLux(full, ir);
+  // Below the register limit the ADC may already have clipped
+  uint16_t limit = saturationLimit(integration);
+  if ((ch0 >= limit) || (ch1 >= limit)) {
+    return -1;
+  }
 
-  return true;
+  uint32_t k = pgm_read_dword(&tsl2591LuxTable[(gain >> 4) & 3][integration]);
+  return calculateLuxMilli(ch0, ch1, k);
 }
 
-/**************************************************************************/
+/************************************************************************/
 /*!
-    @brief  Gets the overall sensor_t data including the type, range and
-   resulution
-    @param  sensor Pointer to Adafruit_Sensor sensor_t object that will be
-   filled with sensor type data
+    @brief  Converts a batch of raw readings taken with the same settings,
+   e.g. a log of getFullLuminosity() words. A wrapper around
+   tsl2591LuxMilliBatch(), which uses SIMD where the CPU has it; every
+   result is identical to calculateLuxMilli(ch0, ch1, gain, integration)
+   when uncalibrated.
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  gain {@link tsl2591Gain_t} gain the data was taken with
+    @param  integration {@link tsl2591IntegrationTime_t} integration time the
+   data was taken with
+    @param  calibration Scale factor, see setLuxCalibration()
 */
 /**************************************************************************/
-void Adafruit_TSL2591::getSensor(sensor_t *sensor) {
-  /* Clear the sensor_t object */
-  memset(sensor, 0, sizeof(sensor_t));
+void Adafruit_TSL2591::calculateLuxMilli(const uint32_t *lum, int32_t *mlux,
+                                         size_t count, tsl2591Gain_t gain,
+                                         tsl2591IntegrationTime_t integration,
+                                         float calibration) {
+  tsl2591LuxMilliBatch(lum, mlux, count, gain | integration, calibration);
+}
 
-  /* Insert the sensor name in the fixed length char array */
-  strncpy(sensor->name, "TSL2591", sizeof(sensor->name) - 1);
-  sensor->name[sizeof(sensor->name) - 1] = 0;
-  sensor->version = 1;
-  sensor->sensor_id = _sensorID;
-  sensor->type = SENSOR_TYPE_LIGHT;
-  sensor->min_delay = 0;
-  sensor->max_value = 88000.0;
-  sensor->min_value = 0.0;
+/************************************************************************/
+/*!
+    @brief  Calculates the visible Lux with integer math only, using the
+   formula selected by TSL2591_LUX_ALGORITHM at compile time. The CPL
+   division is replaced by a multiply with a precomputed Q16 reciprocal (see
+   luxFactor()), so no float math happens at runtime.
+
+   The result is within 1 milli-lux plus 0.012% of the exact formula (the
+   worst case is max gain at 600ms, where the Q16 reciprocal has the fewest
+   significant bits). That is tighter than the previous float code, which
+   lost up to ~24 milli-lux to cancellation in 1 - ch1 / ch0. The AMS and
+   ALT2 formulas round their coefficients to Q16, which adds less than half
+   a count to each term. AMS and ALT2 return 0 when there is no visible light
+   left (IR at or above full spectrum, noise in the dark); ALT1 follows the
+   float formula there, see tsl2591LuxAlt1().
+    @param  ch0 Data from channel 0 (IR+Visible)
+    @param  ch1 Data from channel 1 (IR)
+    @param  k luxFactor() for the settings the data was taken with
+    @returns Milli-lux, or -1 on overflow
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591::calculateLuxMilli(uint16_t ch0, uint16_t ch1,
+                                            uint32_t k) {
+  // Check for overflow conditions first
+  if ((ch0 == 0xFFFF) | (ch1 == 0xFFFF)) {
+    // Signal an overflow
+    return -1;
+  }
+
+  return tsl2591LuxMilli(luxFormula(ch0, ch1, 1), k);
+}
+
+/************************************************************************/
+/*!
+    @brief  Runs the formula selected by TSL2591_LUX_ALGORITHM on channel
+   data or channel sums
+    @param  ch0 Channel 0 (IR+Visible) data, or sum over count conversions
+    @param  ch1 Channel 1 (IR) data, or sum over count conversions
+    @param  count Conversions summed, at least 1
+    @returns Lux of the mean conversion in CH0 counts, 16.16 fixed point (see
+   tsl2591LuxMilli() and tsl2591LuxFloat())
+*/
+/**************************************************************************/
+uint64_t Adafruit_TSL2591::luxFormula(uint32_t ch0, uint32_t ch1,
+                                      uint8_t count) {
+  // Note: These algorithms are based on preliminary coefficients
+  // provided by AMS and may need to be updated in the future
+#if TSL2591_LUX_ALGORITHM == TSL2591_LUX_AMS
+  return tsl2591LuxDual(ch0, ch1, count);
+#elif TSL2591_LUX_ALGORITHM == TSL2591_LUX_ALT2
+  return tsl2591LuxAlt2(ch0, ch1, count);
+#else
+  return tsl2591LuxAlt1(ch0, ch1, count);
+#endif
+}
+
+/************************************************************************/
+/*!
+    @brief  Calculates the mean visible Lux over oversampled channel sums.
+   The sums carry up to 24 bits, so the intermediate math runs in 64 bits;
+   for a single conversion the result equals calculateLuxMilli(ch0, ch1,
+   gain, integration) when uncalibrated.
+    @param  sums Channel sums from pollOversampled() or readOversampled()
+    @param  calibration Scale factor, see setLuxCalibration()
+    @returns Milli-lux, or -1 if any conversion saturated
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591::calculateLuxMilli(const tsl2591Oversample_t *sums,
+                                            float calibration) {
+  if (sums->overflow) {
+    return -1;
+  }
+
+  if (!sums->count) {
+    return 0;
+  }
+
+  uint8_t integration = sums->control & 0x07;
+  if (integration > TSL2591_INTEGRATIONTIME_600MS) {
+    integration = TSL2591_INTEGRATIONTIME_100MS;
+  }
+  uint32_t k = tsl2591Calibrate(
+      pgm_read_dword(&tsl2591LuxTable[(sums->control >> 4) & 3][integration]),
+      tsl2591CalibrationQ16(calibration));
+
+  return tsl2591LuxMilli(luxFormula(sums->ch0, sums->ch1, sums->count), k);
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the raw data from both light channels
+    @returns 32-bit raw count where high word is IR, low word is IR+Visible,
+   or 0 on a bus error (see readFullLuminosity() for the cause)
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591::getFullLuminosity(void) {
+  uint32_t x = 0;
+  readFullLuminosity(&x);
+  return x;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the raw data from both light channels, reporting what went
+   wrong if anything. It gives up at the first transaction that still fails
+   after its retries, so it never blocks longer than the conversion time
+   plus one retry deadline (see setRetryPolicy()).
+    @param  lum Set to the 32-bit raw count where high word is IR, low word
+   is IR+Visible. On TSL2591_ERR_SATURATED it holds the clipped reading, on
+   TSL2591_ERR_TIMEOUT whatever the channel registers held, on other errors
+   it is 0.
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readFullLuminosity(uint32_t *lum) {
+  *lum = 0;
+  _busError = false;
+  if (!_initialized) {
+    if (!begin()) {
+      return _busError ? TSL2591_ERR_BUS : TSL2591_ERR_NOT_FOUND;
+    }
+  }
+
+  bool ready = true;
+  uint32_t x;
+  tsl2591Result_t result;
+  if (_continuous) {
+    // Only wait if no cycle has completed with the current settings yet
+    // (AVALID, setControl() restarts the ADC), for up to the worst case
+    // 120ms per step
+    uint32_t start = millis();
+    uint32_t timeout = (uint32_t)(_integration + 1) * 120;
+    uint8_t status;
+    result = fetchResult(&x, &status);
+    while ((result == TSL2591_OK) && !(status & TSL2591_STATUS_AVALID) &&
+           ((millis() - start) < timeout)) {
+      pause(TSL2591_POLL_INTERVAL_MS);
+      result = fetchResult(&x, &status);
+    }
+    ready = status & TSL2591_STATUS_AVALID;
+  } else {
+    startConversion();
+    if (_busError) {
+      return TSL2591_ERR_BUS;
+    }
+
+    // Sleep through the rest of the nominal integration time (resume() may
+    // have started it already), then poll AVALID until the ADC reports
+    // completion (or the worst case 120ms per step passed)
+    uint32_t timeout = (uint32_t)(_integration + 1) * 120;
+    uint32_t nominal = (uint32_t)(_integration + 1) * 100;
+    uint32_t elapsed = millis() - _conversionStart;
+    if (elapsed < nominal) {
+      pause(nominal - elapsed);
+    }
+    ready = isReady();
+    while (!ready && !_busError && (millis() - _conversionStart) < timeout) {
+      pause(TSL2591_POLL_INTERVAL_MS);
+      ready = isReady();
+    }
+    if (_busError) {
+      return TSL2591_ERR_BUS;
+    }
+    result = readResult(&x);
+  }
+
+  if (result != TSL2591_OK) {
+    return result;
+  }
+  if (_busError) {
+    return TSL2591_ERR_BUS;
+  }
+
+  *lum = x;
+  if (!ready) {
+    return TSL2591_ERR_TIMEOUT;
+  }
+  return isSaturated(x) ? TSL2591_ERR_SATURATED : TSL2591_OK;
+}
+
+/************************************************************************/
+/*!
+    @brief  Checks a reading against the digital and (at 100ms) analog count
+   limits for the current integration time
+    @param  lum 32-bit raw count where high word is IR, low word is
+   IR+Visible
+    @returns True if either channel is saturated
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::isSaturated(uint32_t lum) {
+  uint16_t limit = saturationLimit(_integration);
+  return ((lum & 0xFFFF) >= limit) || ((lum >> 16) >= limit);
+}
+
+/************************************************************************/
+/*!
+    @brief  Takes a reading and converts it to Lux
+    @param  lux Set to the Lux value, < 0 if the sensor saturated
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error from
+   readFullLuminosity()
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readLux(float *lux) {
+  uint32_t x;
+  tsl2591Result_t result = readFullLuminosity(&x);
+  if (result == TSL2591_OK) {
+    *lux = calculateLux(x & 0xFFFF, x >> 16);
+  } else {
+    *lux = (result == TSL2591_ERR_SATURATED) ? -1 : 0;
+  }
+  return result;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the status register
+    @param  status Set to the status register, 0 on error
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readStatus(uint8_t *status) {
+  *status = 0;
+  _busError = false;
+  if (!_initialized) {
+    if (!begin()) {
+      return _busError ? TSL2591_ERR_BUS : TSL2591_ERR_NOT_FOUND;
+    }
+  }
+
+  if (!readBlock(TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS, status,
+                 1)) {
+    *status = 0;
+    return TSL2591_ERR_BUS;
+  }
+  return TSL2591_OK;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads every register from ENABLE to the channel data in one
+   auto-increment transaction, for diagnostics. Reading does not change the
+   chip state.
+    @param  snapshot Filled in with the register contents, zeroed on error
+    @returns TSL2591_OK, TSL2591_ERR_NOT_FOUND if the ID does not match, or
+   the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readSnapshot(tsl2591Snapshot_t *snapshot) {
+  uint8_t raw[TSL2591_REGISTER_CHAN1_HIGH + 1];
+  return readSnapshot(snapshot, raw);
+}
+
+/************************************************************************/
+/*!
+    @brief  Checks in one transaction that the chip still holds the settings
+   the driver last wrote. A power-on or brown-out reset clears them behind
+   our back; the driver keeps the settings it intended, and restoreState()
+   writes back only the registers that differ.
+    @param  snapshot Filled in with the register contents if not NULL
+    @returns TSL2591_OK, TSL2591_ERR_RESET if any setting differs, or the
+   {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::verifyState(tsl2591Snapshot_t *snapshot) {
+  tsl2591Snapshot_t local;
+  uint8_t raw[TSL2591_REGISTER_CHAN1_HIGH + 1];
+  if (!snapshot) {
+    snapshot = &local;
+  }
+
+  tsl2591Result_t result = readSnapshot(snapshot, raw);
+  if (result != TSL2591_OK) {
+    return result;
+  }
+  return checkRegisters(raw) ? TSL2591_ERR_RESET : TSL2591_OK;
+}
+
+/************************************************************************/
+/*!
+    @brief  Writes back the settings verifyState() found lost: gain, timing,
+   thresholds, persist filter and power state, only the registers that
+   differ from what the driver last wrote
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::restoreState(void) {
+  _busError = false;
+  if (!_initialized) {
+    return TSL2591_ERR_NOT_FOUND;
+  }
+
+  restoreRegisters();
+  return _busError ? TSL2591_ERR_BUS : TSL2591_OK;
+}
+
+/************************************************************************/
+/*!
+    @brief  Sets how failed bus transactions are retried. Each retry waits
+   twice as long as the previous one, and no retry is started that would
+   end past the deadline, so one transaction never takes longer than about
+   the deadline however flaky the bus is. Devices reported as
+   TSL2591_HEALTH_FAILED are not retried at all.
+    @param  retries Retries after the first attempt, 0 disables retrying
+    @param  backoffUs Wait before the first retry, in microseconds
+    @param  deadlineMs Longest time one transaction may spend retrying
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::setRetryPolicy(uint8_t retries, uint16_t backoffUs,
+                                      uint16_t deadlineMs) {
+  _retries = retries;
+  _retryBackoffUs = backoffUs;
+  _retryDeadlineMs = deadlineMs;
+}
+
+/************************************************************************/
+/*!
+    @brief  Getter for the health of the bus link, so a scheduler can skip
+   (and occasionally re-begin()) dead sensors. Any successful transaction
+   brings the device back to TSL2591_HEALTH_OK.
+    @returns {@link tsl2591Health_t} health state
+*/
+/**************************************************************************/
+tsl2591Health_t Adafruit_TSL2591::getHealth(void) {
+  if (_consecutiveErrors == 0) {
+    return TSL2591_HEALTH_OK;
+  }
+  return (_consecutiveErrors < TSL2591_HEALTH_FAIL_COUNT)
+             ? TSL2591_HEALTH_DEGRADED
+             : TSL2591_HEALTH_FAILED;
+}
+
+/************************************************************************/
+/*!
+    @brief  Powers up the ALS and starts an integration cycle without waiting
+   for it to complete. Use isReady() to check for completion and readResult()
+   to fetch the data.
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::startConversion(void) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  // In continuous mode the ADC is already running
+  if (_continuous) {
+    return;
+  }
+
+  // Enable the device, the ADC starts integrating right away. A conversion
+  // that is already running (e.g. started by resume()) keeps its start time
+  enable();
+}
+
+/************************************************************************/
+/*!
+    @brief  Checks whether the conversion started by startConversion() has
+   completed
+    @returns True if the AVALID bit is set in the status register
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::isReady(void) {
+  if (!_initialized) {
+    return false;
+  }
+
+  return read8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS) &
+         TSL2591_STATUS_AVALID;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the result of the conversion started by startConversion()
+   and powers the ALS back down
+    @returns 32-bit raw count where high word is IR, low word is IR+Visible,
+   0 if the read failed (see readResult(uint32_t *) to tell why)
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591::readResult(void) {
+  uint32_t x;
+  readResult(&x);
+  return x;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the result of the conversion started by startConversion()
+   and powers the ALS back down, reporting whether the read worked. The
+   counts are not checked for saturation, see isSaturated().
+    @param  lum Set to the 32-bit raw count where high word is IR, low word
+   is IR+Visible, 0 on error
+    @returns TSL2591_OK, TSL2591_ERR_BUS, or after resume() with verify
+   TSL2591_ERR_RESET / TSL2591_ERR_NOT_FOUND
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readResult(uint32_t *lum) {
+  return fetchResult(lum, NULL);
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the latest conversion, in continuous mode along with the
+   status register in the same transaction. A set ALS interrupt flag marks
+   a conversion not read before (startContinuous() has it set every cycle):
+   it advances getSequence() and is cleared, unless serviceInterrupt() owns
+   the flag.
+    @param  lum Set to the 32-bit raw count where high word is IR, low word
+   is IR+Visible, 0 on error
+    @param  status Set to the status register in continuous mode, 0
+   otherwise or on error. May be NULL.
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::fetchResult(uint32_t *lum, uint8_t *status) {
+  *lum = 0;
+  if (status) {
+    *status = 0;
+  }
+  if (!_initialized) {
+    return TSL2591_ERR_NOT_FOUND;
+  }
+
+  // Burst read CHAN0 and CHAN1 in one transaction, so both channels come
+  // from the same conversion (CHAN0 is read first, which latches CHAN1)
+  // See: https://forums.adafruit.com/viewtopic.php?f=19&t=124176
+  // In continuous mode the read starts at STATUS, after resume() at ENABLE
+  // instead, which checks the state it trusted in the same transaction.
+  uint8_t raw[TSL2591_REGISTER_CHAN1_HIGH + 1];
+  uint8_t first = _verifyPending ? TSL2591_REGISTER_ENABLE
+                  : _continuous  ? TSL2591_REGISTER_DEVICE_STATUS
+                                 : TSL2591_REGISTER_CHAN0_LOW;
+  if (!readBlock(TSL2591_COMMAND_BIT | first, raw + first,
+                 sizeof(raw) - first)) {
+    if (!_continuous)
+      disable();
+    return TSL2591_ERR_BUS;
+  }
+  if (_verifyPending) {
+    _verifyPending = false;
+    if (raw[TSL2591_REGISTER_DEVICE_ID] != 0x50) {
+      // Not the chip we saved, power down the ALS resume() left running
+      // and forget it
+      disable();
+      _initialized = false;
+      return TSL2591_ERR_NOT_FOUND;
+    }
+
+    if (checkRegisters(raw)) {
+      // The chip was reset while we slept and converted with its defaults
+      restoreRegisters();
+      if (!_continuous)
+        disable();
+      return TSL2591_ERR_RESET;
+    }
+  }
+  uint8_t *buffer = raw + TSL2591_REGISTER_CHAN0_LOW;
+  uint32_t x = uint32_t(buffer[3]) << 24 | uint32_t(buffer[2]) << 16 |
+               uint32_t(buffer[1]) << 8 | uint32_t(buffer[0]);
+
+  // In continuous mode the same conversion may be read more than once
+  bool fresh = true;
+  if (_continuous) {
+    uint8_t flags = raw[TSL2591_REGISTER_DEVICE_STATUS];
+    if (status) {
+      *status = flags;
+    }
+    fresh = flags & TSL2591_STATUS_AINT;
+    if (fresh) {
+      _sequence++;
+      if (!_queue && !_trackingPercent) {
+        write8(TSL2591_CLEAR_ALS_INT);
+      }
+    }
+  }
+
+  TSL2591_STAT(_stats.conversions++);
+  TSL2591_STAT(_stats.saturations += isSaturated(x));
+
+  if (_samples && fresh) {
+    tsl2591Sample_t sample;
+    sample.timestamp = millis();
+    sample.ch0 = x & 0xFFFF;
+    sample.ch1 = x >> 16;
+    sample.control = _integration | _gain;
+    _samples->push(&sample, calculateLuxMilli(sample.ch0, sample.ch1));
+  }
+
+  if (!_continuous)
+    disable();
+
+  *lum = x;
+  return TSL2591_OK;
+}
+
+/************************************************************************/
+/*!
+    @brief  Powers up the ALS and leaves it running, so new data is produced
+   every integration period. Reads then return the latest completed
+   conversion without waiting, until stopContinuous() or disable() is called.
+
+   The chip flags each completed conversion with the ALS interrupt, so the
+   persist filter is set to fire every cycle (INT follows it if wired) and
+   the one set with registerInterrupt() is put back when continuous mode
+   stops. Tracking mode keeps its own filter.
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::startContinuous(void) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  if (!_continuous) {
+    if (!_trackingPercent) {
+      _continuousPersist = _regs[TSL2591_REGISTER_PERSIST_FILTER];
+      updateRegister(TSL2591_REGISTER_PERSIST_FILTER, TSL2591_PERSIST_EVERY);
+    }
+    // A flag left from before is not one of our conversions
+    write8(TSL2591_CLEAR_ALS_INT);
+    _sequence = 0;
+  }
+  enable();
+  _continuous = true;
+}
+
+/************************************************************************/
+/*!
+    @brief  Leaves continuous mode and powers the ALS down
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::stopContinuous(void) { disable(); }
+
+/************************************************************************/
+/*!
+    @brief  Getter for continuous measurement mode
+    @returns True if the ALS is being kept powered between reads
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591::isContinuous(void) { return _continuous; }
+
+/************************************************************************/
+/*!
+    @brief  Counts the conversions read since continuous mode was started.
+   Each read checks the chip's ALS interrupt flag, so the count only moves
+   when a read returned a conversion not seen before; it does no bus access
+   itself. In tracking mode the flag is only set when the window trips.
+    @returns Number of new conversions read, 0 if none yet (or not in
+   continuous mode)
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591::getSequence(void) {
+  return _continuous ? _sequence : 0;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the latest completed conversion. In continuous mode this
+   is a single status and channel read with no waiting, otherwise it falls
+   back to a full (blocking) getFullLuminosity()
+    @param  sequence Optional pointer that is filled with getSequence() for
+   the returned data, so callers can tell fresh samples from repeats. It is
+   0 outside continuous mode, and in it when there is no data (nothing new
+   read yet, or the read failed, both return 0).
+    @returns 32-bit raw count where high word is IR, low word is IR+Visible
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591::getLatestLuminosity(uint32_t *sequence) {
+  uint32_t seq = 0;
+  uint32_t x = 0;
+
+  if (!_continuous) {
+    x = getFullLuminosity();
+  } else if ((readResult(&x) == TSL2591_OK) && (_sequence != 0)) {
+    seq = _sequence;
+  } else {
+    // Nothing new was read since continuous mode started, or the read failed
+    x = 0;
+  }
+
+  if (sequence) {
+    *sequence = seq;
+  }
+  return x;
+}
+
+/************************************************************************/
+/*!
+    @brief  Starts summing conversions in continuous mode, so no time is
+   lost powering the ADC up and down between them. Every decimation
+   conversions pollOversampled() hands out the channel sums, which extend
+   the resolution past 16 bits and average out noise in dim light.
+    @param  decimation Conversions summed into each result (1..255)
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::startOversampling(uint8_t decimation) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  _decimation = decimation ? decimation : 1;
+  memset(&_accum, 0, sizeof(_accum));
+  if (!_continuous) {
+    startContinuous();
+  } else {
+    // A conversion flagged before now does not belong in the sums
+    write8(TSL2591_CLEAR_ALS_INT);
+  }
+}
+
+/************************************************************************/
+/*!
+    @brief  Stops oversampling and powers the ALS down, a partial sum is
+   discarded
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::stopOversampling(void) {
+  _decimation = 0;
+  stopContinuous();
+}
+
+/************************************************************************/
+/*!
+    @brief  Adds the latest conversion to the sums if the chip flags it as
+   new, without waiting: one status and channel read per call. Call it at
+   least once per integration period, a conversion that is not picked up
+   before the next one completes is skipped.
+    @param  sums Filled with the channel sums when a result is complete
+    @returns True if sums holds a new result
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::pollOversampled(tsl2591Oversample_t *sums) {
+  if (!_decimation || !_continuous) {
+    return false;
+  }
+
+  _busError = false;
+  uint32_t x;
+  uint8_t status;
+  if ((fetchResult(&x, &status) != TSL2591_OK) ||
+      !(status & TSL2591_STATUS_AINT)) {
+    return false;
+  }
+
+  accumulate(x);
+  if (_accum.count < _decimation) {
+    return false;
+  }
+
+  *sums = _accum;
+  memset(&_accum, 0, sizeof(_accum));
+  return true;
+}
+
+/************************************************************************/
+/*!
+    @brief  Sums count back to back conversions, blocking until they are
+   done. Oversampling (and continuous mode) is left running, so calling it
+   again with the same count just collects the next result.
+    @param  count Conversions to sum (1..255)
+    @param  sums Filled with the channel sums, zeroed on error
+    @returns TSL2591_OK, or the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readOversampled(uint8_t count,
+                                                  tsl2591Oversample_t *sums) {
+  memset(sums, 0, sizeof(*sums));
+  _busError = false;
+  if (!_initialized) {
+    if (!begin()) {
+      return _busError ? TSL2591_ERR_BUS : TSL2591_ERR_NOT_FOUND;
+    }
+  }
+
+  if ((_decimation != count) || !_continuous) {
+    startOversampling(count);
+  }
+
+  // Worst case 120ms per step for every conversion, plus one partial cycle
+  uint32_t start = millis();
+  uint32_t timeout = (uint32_t)(_integration + 1) * 120 * (_decimation + 1);
+  while (!pollOversampled(sums)) {
+    if (_busError) {
+      return TSL2591_ERR_BUS;
+    }
+    if (!_initialized) {
+      return TSL2591_ERR_NOT_FOUND;
+    }
+    if ((millis() - start) > timeout) {
+      return TSL2591_ERR_TIMEOUT;
+    }
+    pause(TSL2591_POLL_INTERVAL_MS);
+  }
+
+  return sums->overflow ? TSL2591_ERR_SATURATED : TSL2591_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds one conversion to the oversampling sums. If the gain or
+   integration time changed since the sums were started, the counts are
+   rescaled to whichever of the two settings is less sensitive, so the
+   sums never overflow and stay consistent with their control value.
+    @param  lum 32-bit raw count where high word is IR, low word is
+   IR+Visible
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::accumulate(uint32_t lum) {
+  uint8_t control = _integration | _gain;
+  uint32_t ch0 = lum & 0xFFFF;
+  uint32_t ch1 = lum >> 16;
+
+  if (isSaturated(lum)) {
+    _accum.overflow = true;
+  }
+
+  if (_accum.count == 0) {
+    _accum.control = control;
+  } else if (control != _accum.control) {
+    uint32_t sens = tsl2591Sensitivity(_gain, _integration);
+    uint32_t ref =
+        tsl2591Sensitivity((tsl2591Gain_t)(_accum.control & 0x30),
+                           (tsl2591IntegrationTime_t)(_accum.control & 0x07));
+    if (sens < ref) {
+      _accum.ch0 = ((uint64_t)_accum.ch0 * sens + ref / 2) / ref;
+      _accum.ch1 = ((uint64_t)_accum.ch1 * sens + ref / 2) / ref;
+      _accum.control = control;
+    } else {
+      ch0 = (ch0 * ref + sens / 2) / sens;
+      ch1 = (ch1 * ref + sens / 2) / sens;
+    }
+  }
+
+  _accum.ch0 += ch0;
+  _accum.ch1 += ch1;
+  _accum.count++;
+}
+
+/************************************************************************/
+/*!
+    @brief  Reads the raw data from the channel
+    @param  channel Can be 0 (IR+Visible, 1 (IR) or 2 (Visible only)
+    @returns 16-bit raw count, or 0 if channel is invalid
+*/
+/**************************************************************************/
+uint16_t Adafruit_TSL2591::getLuminosity(uint8_t channel) {
+  uint32_t x = getFullLuminosity();
+
+  if (channel == TSL2591_FULLSPECTRUM) {
+    // Reads two byte value from channel 0 (visible + infrared)
+    return (x & 0xFFFF);
+  } else if (channel == TSL2591_INFRARED) {
+    // Reads two byte value from channel 1 (infrared)
+    return (x >> 16);
+  } else if (channel == TSL2591_VISIBLE) {
+    // Reads all and subtracts out just the visible!
+    return ((x & 0xFFFF) - (x >> 16));
+  }
+
+  // unknown channel!
+  return 0;
+}
+
+/************************************************************************/
+/*!
+    @brief  Set up the interrupt to go off when light level is outside the
+   lower/upper range.
+    @param  lowerThreshold Raw light data reading level that is the lower value
+   threshold for interrupt
+    @param  upperThreshold Raw light data reading level that is the higher value
+   threshold for interrupt
+    @param  persist How many counts we must be outside range for interrupt to
+   fire, default is any single value. In continuous mode it takes effect
+   when continuous mode stops, see startContinuous().
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::registerInterrupt(
+    uint16_t lowerThreshold, uint16_t upperThreshold,
+    tsl2591Persist_t persist = TSL2591_PERSIST_ANY) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  uint8_t buffer[4];
+  buffer[0] = lowerThreshold;
+  buffer[1] = lowerThreshold >> 8;
+  buffer[2] = upperThreshold;
+  buffer[3] = upperThreshold >> 8;
+  updateRegisters(TSL2591_REGISTER_THRESHOLD_AILTL, buffer, 4);
+  updateRegister(TSL2591_REGISTER_PERSIST_FILTER, continuousPersist(persist));
+}
+
+/************************************************************************/
+/*!
+    @brief  Set up both the persist and no-persist interrupt windows. The
+   thresholds and the persist filter are contiguous (0x04..0x0C), so they are
+   programmed with a single auto-increment block write covering only the
+   registers that changed.
+    @param  lowerThreshold Raw CH0 level below which the ALS (persist)
+   interrupt fires
+    @param  upperThreshold Raw CH0 level above which the ALS (persist)
+   interrupt fires
+    @param  npLowerThreshold Raw CH0 level below which the no-persist
+   interrupt fires
+    @param  npUpperThreshold Raw CH0 level above which the no-persist
+   interrupt fires
+    @param  persist How many counts we must be outside the persist range for
+   the ALS interrupt to fire. In continuous mode it takes effect when
+   continuous mode stops, see startContinuous().
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::registerInterrupt(uint16_t lowerThreshold,
+                                         uint16_t upperThreshold,
+                                         uint16_t npLowerThreshold,
+                                         uint16_t npUpperThreshold,
+                                         tsl2591Persist_t persist) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  uint8_t buffer[9];
+  buffer[0] = lowerThreshold;
+  buffer[1] = lowerThreshold >> 8;
+  buffer[2] = upperThreshold;
+  buffer[3] = upperThreshold >> 8;
+  buffer[4] = npLowerThreshold;
+  buffer[5] = npLowerThreshold >> 8;
+  buffer[6] = npUpperThreshold;
+  buffer[7] = npUpperThreshold >> 8;
+  buffer[8] = continuousPersist(persist);
+  updateRegisters(TSL2591_REGISTER_THRESHOLD_AILTL, buffer, 9);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Picks the persist filter to program. Continuous mode needs the
+   ALS interrupt on every cycle, so a caller's filter is kept for when it
+   stops; tracking mode programs its own.
+    @param  persist The filter the caller asked for
+    @returns The filter to write to the chip
+*/
+/**************************************************************************/
+uint8_t Adafruit_TSL2591::continuousPersist(uint8_t persist) {
+  if (!_continuous || _trackingPercent) {
+    return persist;
+  }
+  _continuousPersist = persist;
+  return TSL2591_PERSIST_EVERY;
+}
+
+/************************************************************************/
+/*!
+    @brief  Clear interrupt status
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::clearInterrupt() {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  // Special function commands don't need the ALS powered up
+  write8(TSL2591_CLEAR_INT);
+}
+
+/************************************************************************/
+/*!
+    @brief  Gets the most recent sensor event from the hardware status register.
+    @return Sensor status as a byte. Bit 0 is ALS Valid. Bit 4 is ALS Interrupt.
+   Bit 5 is No-persist Interrupt.
+*/
+/**************************************************************************/
+uint8_t Adafruit_TSL2591::getStatus(void) {
+  if (!_initialized) {
+    if (!begin()) {
+      return 0;
+    }
+  }
+
+  return read8(TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS);
+}
+
+/************************************************************************/
+/*!
+    @brief  Gets the most recent sensor event
+    @param  event Pointer to Adafruit_Sensor sensors_event_t object that will be
+   filled with sensor data
+    @return True on success, False if the sensor could not be read (bus
+   error, not found, or reset). A saturated reading, or one whose conversion
+   timed out, is still reported as before.
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::getEvent(sensors_event_t *event) {
+  uint16_t ir, full;
+  uint32_t lum;
+  tsl2591Result_t result = readFullLuminosity(&lum);
+  /* Early silicon seems to have issues when there is a sudden jump in */
+  /* light levels. :( To work around this sample the sensor 2x, either */
+  /* always or only when the level jumped (see setSettlePolicy)        */
+  if (eventReading(result) && needsSettling(lum)) {
+    result = readFullLuminosity(&lum);
+  }
+  /* A saturated reading is still reported, its light is -1 */
+  if (!eventReading(result)) {
+    return false;
+  }
+  _lastLum = lum;
+  _lastControl = _integration | _gain;
+  ir = lum >> 16;
+  full = lum & 0xFFFF;
+
+  /* Clear the event */
+  memset(event, 0, sizeof(sensors_event_t));
+
+  event->version = sizeof(sensors_event_t);
+  event->sensor_id = _sensorID;
+  event->type = SENSOR_TYPE_LIGHT;
+  event->timestamp = millis();
+
+  /* Calculate the actual lux value */
+  /* -1 = sensor saturated (too much light) */
+  event->light = calculateLux(full, ir);
+
+  return true;
+}
+
+/************************************************************************/
+/*!
+    @brief  Tells whether a readFullLuminosity() result still carries a
+   reading getEvent() reports. A timed out conversion returns what the
+   channel registers held, as getEvent() always did.
+    @param  result {@link tsl2591Result_t} result
+    @returns True for TSL2591_OK, TSL2591_ERR_SATURATED and
+   TSL2591_ERR_TIMEOUT
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::eventReading(tsl2591Result_t result) {
+  return (result == TSL2591_OK) || (result == TSL2591_ERR_SATURATED) ||
+         (result == TSL2591_ERR_TIMEOUT);
+}
+
+/************************************************************************/
+/*!
+    @brief  Attaches a sample buffer that every completed reading is pushed
+   into, as raw counts plus gain/integration, along with its lux value
+    @param  buffer The buffer (e.g. an Adafruit_TSL2591_SampleRing<N>), or
+   NULL to stop recording
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::setSampleBuffer(Adafruit_TSL2591_SampleBuffer *buffer) {
+  _samples = buffer;
+}
+
+/************************************************************************/
+/*!
+    @brief  Switches to interrupt driven sampling: the ALS runs continuously
+   with the persist filter set to fire on every cycle, so the INT pin signals
+   each completed conversion. Call handleInterrupt() from the pin ISR and
+   serviceInterrupt() to move the data into the queue.
+    @param  queue Where completed samples are pushed
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::startDataReadyInterrupt(
+    Adafruit_TSL2591_SampleQueue *queue) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  _queue = queue;
+  _interruptsServiced = _interruptsRaised;
+  write8(TSL2591_CLEAR_INT);
+  startContinuous();
+}
+
+/************************************************************************/
+/*!
+    @brief  Stops interrupt driven sampling (or tracking) and powers the ALS
+   down. Tracking puts back the thresholds and persist filter it took over.
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::stopDataReadyInterrupt(void) {
+  _queue = NULL;
+  stopContinuous();
+  write8(TSL2591_CLEAR_INT);
+}
+
+/************************************************************************/
+/*!
+    @brief  Switches to change-only reporting: the persist window is centered
+   on the current CH0 reading and re-centered on the new reading after every
+   interrupt, so INT only fires when the light level moves by more than the
+   band. Call handleInterrupt() from the pin ISR and serviceInterrupt() to
+   re-arm the window.
+
+   Tracking takes over the ALS thresholds and the persist filter. It also
+   opens the no-persist window fully, since that interrupt is enabled with
+   the ALS and would otherwise wake it too. All of them are put back as they
+   were by stopDataReadyInterrupt() or disable().
+    @param  bandPercent Half width of the window, in percent of CH0
+    @param  persist How many consecutive readings must be outside the window
+   before the interrupt fires
+    @param  queue Optional queue the reading that caused each interrupt is
+   pushed into
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::startTrackingInterrupt(
+    uint8_t bandPercent, tsl2591Persist_t persist,
+    Adafruit_TSL2591_SampleQueue *queue) {
+  if (!_initialized) {
+    if (!begin()) {
+      return;
+    }
+  }
+
+  if (!_trackingPercent) {
+    // Not tracking yet, so the cache holds the caller's settings, except
+    // for a persist filter continuous mode borrowed
+    memcpy(_trackingSaved, &_regs[TSL2591_REGISTER_THRESHOLD_AILTL],
+           sizeof(_trackingSaved));
+    if (_continuous) {
+      _trackingSaved[sizeof(_trackingSaved) - 1] = _continuousPersist;
+    }
+  }
+
+  // Center the first window on a fresh reading, taken before tracking
+  // starts since a one-shot read ends with disable()
+  uint32_t x = getFullLuminosity();
+  _queue = queue;
+  _trackingPercent = bandPercent;
+  _trackingPersist = persist;
+  _interruptsServiced = _interruptsRaised;
+  retrack(x & 0xFFFF);
+  write8(TSL2591_CLEAR_INT);
+  startContinuous();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Re-centers the tracking window on a CH0 reading. The window is
+   at least TSL2591_TRACKING_MIN_BAND counts wide on each side so noise at
+   low counts does not keep it firing, and its top is kept below the count
+   limit for the current integration time so saturation still trips it.
+   While saturated the window has no top, so it only fires once the light
+   drops back by the band instead of on every cycle.
+    @param  ch0 CH0 counts to center on
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::retrack(uint16_t ch0) {
+  uint16_t limit = saturationLimit(_integration);
+  uint32_t band = (uint32_t)ch0 * _trackingPercent / 100;
+  if (band < TSL2591_TRACKING_MIN_BAND) {
+    band = TSL2591_TRACKING_MIN_BAND;
+  }
+
+  uint16_t lower = (ch0 > band) ? ch0 - band : 0;
+  uint32_t upper = ch0 + band;
+  if (ch0 >= limit) {
+    upper = 0xFFFF;
+  } else if (upper >= limit) {
+    upper = limit - 1;
+  }
+
+  // Open the no-persist window fully, so only the tracking window wakes us
+  registerInterrupt(lower, upper, 0, 0xFFFF, _trackingPersist);
+}
+
+/************************************************************************/
+/*!
+    @brief  Notes that the INT pin fired. Does no bus access and only
+   writes a byte no other code writes, so it is safe to call from an
+   interrupt handler on every core.
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::handleInterrupt(void) {
+  _interruptsRaised = _interruptsRaised + 1;
+}
+
+/************************************************************************/
+/*!
+    @brief  Fetches the completed conversion and clears the interrupt, two
+   bus transactions with no status polling, then pushes the sample into the
+   queue. In tracking mode the window is re-centered first (one more block
+   write). Call it from the main loop or a task after handleInterrupt(), not
+   from the ISR: it goes through the I2C driver. When several interrupts
+   were raised since the last call, only the latest conversion can still be
+   read, the others are counted as dropped by the queue. So is a conversion
+   that could not be read.
+    @returns True if a sample was fetched
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::serviceInterrupt(void) {
+  if (!_queue && !_trackingPercent) {
+    return false;
+  }
+
+  // The ISR only moves _interruptsRaised and this only moves
+  // _interruptsServiced, so a byte read of each needs no critical section
+  uint8_t raised = _interruptsRaised;
+  uint8_t pending = raised - _interruptsServiced;
+  if (!pending) {
+    return false;
+  }
+  _interruptsServiced = raised;
+  if (_queue && (pending > 1)) {
+    // The conversions behind the earlier interrupts were overwritten
+    _queue->drop(pending - 1);
+  }
+
+  uint32_t x;
+  tsl2591Result_t result = readResult(&x);
+  if ((result == TSL2591_OK) && _trackingPercent) {
+    // Re-arm before clearing, so a reading still outside the old window
+    // does not fire again
+    retrack(x & 0xFFFF);
+  }
+  if (_initialized) {
+    write8(TSL2591_CLEAR_INT);
+  }
+
+  if (result != TSL2591_OK) {
+    if (_queue) {
+      _queue->drop(1);
+    }
+    return false;
+  }
+  if (!_queue) {
+    return true;
+  }
+
+  tsl2591Sample_t sample;
+  sample.timestamp = millis();
+  sample.ch0 = x & 0xFFFF;
+  sample.ch1 = x >> 16;
+  sample.control = _integration | _gain;
+  _queue->push(&sample);
+  return true;
+}
+
+/************************************************************************/
+/*!
+    @brief  Selects when getEvent() takes a second conversion to let the
+   sensor settle after a sudden change in light level
+    @param  policy {@link tsl2591Settle_t} TSL2591_SETTLE_DOUBLE always
+   samples twice (the default), TSL2591_SETTLE_SINGLE never does and
+   TSL2591_SETTLE_ADAPTIVE only does when the first reading moved too far
+    @param  thresholdPercent For the adaptive policy, how far CH0 may move
+   from the previous event (in percent) before a second sample is taken
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::setSettlePolicy(tsl2591Settle_t policy,
+                                       uint8_t thresholdPercent) {
+  _settlePolicy = policy;
+  _settleThreshold = thresholdPercent;
+}
+
+/************************************************************************/
+/*!
+    @brief  Getter for the getEvent() settle policy
+    @returns {@link tsl2591Settle_t} settle policy
+*/
+/**************************************************************************/
+tsl2591Settle_t Adafruit_TSL2591::getSettlePolicy(void) {
+  return _settlePolicy;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Decides whether a getEvent() reading should be retaken
+    @param  lum First reading, as returned by getFullLuminosity()
+    @returns True if a second conversion is needed
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::needsSettling(uint32_t lum) {
+  if (_settlePolicy == TSL2591_SETTLE_SINGLE) {
+    return false;
+  }
+  if (_settlePolicy == TSL2591_SETTLE_DOUBLE) {
+    return true;
+  }
+
+  // Adaptive: nothing to compare against if the settings changed
+  if (_lastControl != (_integration | _gain)) {
+    return true;
+  }
+
+  uint32_t ch0 = lum & 0xFFFF;
+  uint32_t last = _lastLum & 0xFFFF;
+  uint32_t delta = ch0 > last ? ch0 - last : last - ch0;
+  return (delta * 100) > (last * _settleThreshold);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the overall sensor_t data including the type, range and
+   resulution
+    @param  sensor Pointer to Adafruit_Sensor sensor_t object that will be
+   filled with sensor type data
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::getSensor(sensor_t *sensor) {
+  /* Clear the sensor_t object */
+  memset(sensor, 0, sizeof(sensor_t));
+
+  /* Insert the sensor name in the fixed length char array */
+  strncpy(sensor->name, "TSL2591", sizeof(sensor->name) - 1);
+  sensor->name[sizeof(sensor->name) - 1] = 0;
+  sensor->version = 1;
+  sensor->sensor_id = _sensorID;
+  sensor->type = SENSOR_TYPE_LIGHT;
+  sensor->min_delay = 0;
+  sensor->max_value = 88000.0;
+  sensor->min_value = 0.0;
   sensor->resolution = 0.001;
 }
+/**************************************************************************/
+/*!
+    @brief  Installs a function that is called after every I2C transaction
+   the driver issues, with what was sent, how much was read and when. The
+   address probe in begin() is reported too, as TSL2591_ADDRESS_PROBE. This
+   makes the bus cost of each call observable on hardware, or on a host
+   against the simulated sensor in extras/host.
+    @param  monitor Callback, or NULL to remove it
+    @param  context Passed through to monitor
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::setBusMonitor(tsl2591BusMonitor_t monitor,
+                                     void *context) {
+  _busMonitor = monitor;
+  _busMonitorContext = context;
+}
+
+#if TSL2591_ENABLE_STATS
+/**************************************************************************/
+/*!
+    @brief  Copies the hot path counters. Only built with
+   TSL2591_ENABLE_STATS set, for the library and the sketch alike.
+    @param  stats Pointer to a tsl2591Stats_t that will be filled in
+    @returns True
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::getStats(tsl2591Stats_t *stats) {
+  *stats = _stats;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears the hot path counters
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::resetStats(void) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+#endif
+
 /*******************************************************/
 
 uint8_t Adafruit_TSL2591::read8(uint8_t reg) {
-  uint8_t buffer[1];
-  buffer[0] = reg;
-  i2c_dev->write_then_read(buffer, 1, buffer, 1);
+  uint8_t buffer[1] = {0};
+  readBlock(reg, buffer, 1);
   return buffer[0];
 }
 
 uint16_t Adafruit_TSL2591::read16(uint8_t reg) {
-  uint8_t buffer[2];
-  buffer[0] = reg;
-  i2c_dev->write_then_read(buffer, 1, buffer, 2);
+  uint8_t buffer[2] = {0, 0};
+  readBlock(reg, buffer, 2);
   return uint16_t(buffer[1]) << 8 | uint16_t(buffer[0]);
 }
 
-void Adafruit_TSL2591::write8(uint8_t reg, uint8_t value) {
-  uint8_t buffer[2];
-  buffer[0] = reg;
-  buffer[1] = value;
-  i2c_dev->write(buffer, 2);
+/**************************************************************************/
+/*!
+    @brief  Reads a run of registers in one auto-increment transaction. This
+   is the raw bus access shared with Adafruit_TSL2591_Fixed, it is not
+   reported to the bus monitor.
+    @param  device I2C device to use
+    @param  reg First register, including the command bit
+    @param  buffer Where to put the data
+    @param  len Number of bytes to read
+    @returns True if the I2C device reported success
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::readRegisters(Adafruit_I2CDevice *device, uint8_t reg,
+                                     uint8_t *buffer, uint8_t len) {
+  return device->write_then_read(&reg, 1, buffer, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a run of registers in one auto-increment transaction, the
+   counterpart of readRegisters()
+    @param  device I2C device to use
+    @param  reg First register, including the command bit
+    @param  buffer Data to write
+    @param  len Number of bytes to write
+    @returns True if the I2C device reported success
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::writeRegisters(Adafruit_I2CDevice *device, uint8_t reg,
+                                      const uint8_t *buffer, uint8_t len) {
+  return device->write(buffer, len, true, &reg, 1);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Issues one bus transaction, retrying it as set by
+   setRetryPolicy(). Retries stop early when the deadline would be passed or
+   the device is already reported as failed, so a dead sensor costs a single
+   attempt. A final failure is counted towards getHealth() and latched in
+   _busError for the result code APIs.
+    @param  reg Command byte (register or special function)
+    @param  out Data to write after the command byte
+    @param  outLen Number of bytes to write
+    @param  in Where to put the data read back
+    @param  inLen Number of bytes to read, 0 for a write
+    @returns True if the transaction (eventually) succeeded
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::transfer(uint8_t reg, const uint8_t *out,
+                                uint8_t outLen, uint8_t *in, uint8_t inLen) {
+  uint32_t first = micros();
+  uint32_t deadline = (uint32_t)_retryDeadlineMs * 1000;
+  uint16_t backoff = _retryBackoffUs;
+  uint8_t attempt = 0;
+
+  while (true) {
+    uint32_t start = _busMonitor ? micros() : 0;
+    bool ok;
+    if (inLen) {
+      ok = readRegisters(i2c_dev, reg, in, inLen);
+    } else if (outLen) {
+      ok = writeRegisters(i2c_dev, reg, out, outLen);
+    } else {
+      ok = i2c_dev->write(&reg, 1);
+    }
+    recordTransaction(start, reg, outLen, inLen, ok);
+
+    if (ok) {
+      _consecutiveErrors = 0;
+      return true;
+    }
+
+    if ((attempt++ >= _retries) ||
+        (_consecutiveErrors >= TSL2591_HEALTH_FAIL_COUNT) ||
+        (micros() - first + backoff > deadline)) {
+      break;
+    }
+    delayMicroseconds(backoff);
+    if (backoff < 0x2000) {
+      backoff <<= 1;
+    }
+  }
+
+  if (_consecutiveErrors < 0xFF) {
+    _consecutiveErrors++;
+  }
+  _busError = true;
+  return false;
+}
+
+bool Adafruit_TSL2591::readBlock(uint8_t reg, uint8_t *buffer, uint8_t len) {
+  return transfer(reg, NULL, 0, buffer, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads and decodes every register from ENABLE to the channel data
+   in one auto-increment transaction
+    @param  snapshot Filled in with the register contents, zeroed on error
+    @param  raw Filled in with the registers, TSL2591_REGISTER_CHAN1_HIGH + 1
+   bytes in register order
+    @returns TSL2591_OK, TSL2591_ERR_NOT_FOUND if the ID does not match, or
+   the {@link tsl2591Result_t} error
+*/
+/**************************************************************************/
+tsl2591Result_t Adafruit_TSL2591::readSnapshot(tsl2591Snapshot_t *snapshot,
+                                               uint8_t *raw) {
+  memset(snapshot, 0, sizeof(*snapshot));
+  _busError = false;
+  if (!_initialized) {
+    if (!begin()) {
+      return _busError ? TSL2591_ERR_BUS : TSL2591_ERR_NOT_FOUND;
+    }
+  }
+
+  if (!readBlock(TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE, raw,
+                 TSL2591_REGISTER_CHAN1_HIGH + 1)) {
+    return TSL2591_ERR_BUS;
+  }
+
+  snapshot->enable = raw[TSL2591_REGISTER_ENABLE];
+  snapshot->control = raw[TSL2591_REGISTER_CONTROL];
+  snapshot->lowerThreshold = raw[TSL2591_REGISTER_THRESHOLD_AILTH] << 8 |
+                             raw[TSL2591_REGISTER_THRESHOLD_AILTL];
+  snapshot->upperThreshold = raw[TSL2591_REGISTER_THRESHOLD_AIHTH] << 8 |
+                             raw[TSL2591_REGISTER_THRESHOLD_AIHTL];
+  snapshot->npLowerThreshold = raw[TSL2591_REGISTER_THRESHOLD_NPAILTH] << 8 |
+                               raw[TSL2591_REGISTER_THRESHOLD_NPAILTL];
+  snapshot->npUpperThreshold = raw[TSL2591_REGISTER_THRESHOLD_NPAIHTH] << 8 |
+                               raw[TSL2591_REGISTER_THRESHOLD_NPAIHTL];
+  snapshot->persist = raw[TSL2591_REGISTER_PERSIST_FILTER];
+  snapshot->pid = raw[TSL2591_REGISTER_PACKAGE_PID];
+  snapshot->id = raw[TSL2591_REGISTER_DEVICE_ID];
+  snapshot->status = raw[TSL2591_REGISTER_DEVICE_STATUS];
+  snapshot->ch0 =
+      raw[TSL2591_REGISTER_CHAN0_HIGH] << 8 | raw[TSL2591_REGISTER_CHAN0_LOW];
+  snapshot->ch1 =
+      raw[TSL2591_REGISTER_CHAN1_HIGH] << 8 | raw[TSL2591_REGISTER_CHAN1_LOW];
+
+  if (snapshot->id != 0x50) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    return TSL2591_ERR_NOT_FOUND;
+  }
+  return TSL2591_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compares ENABLE..PERSIST as read from the chip against the shadow
+   cache. The cache keeps the values the driver intends, a register the chip
+   no longer holds is only marked unknown so restoreRegisters() rewrites it.
+    @param  raw Registers in register order, starting at ENABLE
+    @returns True if the chip no longer holds our settings
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::checkRegisters(const uint8_t *raw) {
+  bool lost = false;
+  _regs[TSL2591_REGISTER_CONTROL] = _integration | _gain;
+  for (uint8_t r = 0; r < sizeof(_regs); r++) {
+    // 0x02 and 0x03 are reserved, we never write them
+    if ((r != 2) && (r != 3) && (_regs[r] != raw[r])) {
+      _regsValid &= ~(1 << r);
+      lost = true;
+    }
+  }
+  return lost;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the shadow cache back to the chip, one block write that
+   spans the registers marked unknown or changed. ENABLE goes last, so the
+   first conversion after a reset already uses the settings.
+    @returns True if a write was issued
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::restoreRegisters(void) {
+  uint8_t values[sizeof(_regs)];
+  memcpy(values, _regs, sizeof(values));
+  bool written = updateRegisters(TSL2591_REGISTER_CONTROL,
+                                 values + TSL2591_REGISTER_CONTROL,
+                                 sizeof(values) - TSL2591_REGISTER_CONTROL);
+  if (updateRegister(TSL2591_REGISTER_ENABLE, values[TSL2591_REGISTER_ENABLE]))
+    written = true;
+  return written;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a configuration register through the shadow cache, the bus
+   is only touched if the value differs from what the chip already holds
+    @param  reg Register address (ENABLE..PERSIST, without the command bit)
+    @param  value Value to write
+    @returns True if a write was issued
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::updateRegister(uint8_t reg, uint8_t value) {
+  uint16_t bit = 1 << reg;
+  if ((_regsValid & bit) && (_regs[reg] == value)) {
+    return false;
+  }
+
+  if (!write8(TSL2591_COMMAND_BIT | reg, value)) {
+    // We no longer know what the chip holds
+    _regsValid &= ~bit;
+    return true;
+  }
+  _regs[reg] = value;
+  _regsValid |= bit;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a run of configuration registers through the shadow cache,
+   issuing one block write that spans only the registers that changed
+    @param  reg First register address (without the command bit)
+    @param  values Values for reg, reg + 1, ...
+    @param  len Number of registers, reg + len must not go past PERSIST
+    @returns True if a write was issued
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591::updateRegisters(uint8_t reg, const uint8_t *values,
+                                       uint8_t len) {
+  int8_t first = -1, last = -1;
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t r = reg + i;
+    if (!(_regsValid & (1 << r)) || (_regs[r] != values[i])) {
+      if (first < 0) {
+        first = i;
+      }
+      last = i;
+    }
+  }
+
+  if (first < 0) {
+    return false;
+  }
+
+  bool ok = writeBlock(TSL2591_COMMAND_BIT | (reg + first), values + first,
+                       last - first + 1);
+  for (uint8_t i = first; i <= last; i++) {
+    _regs[reg + i] = values[i];
+    if (ok) {
+      _regsValid |= 1 << (reg + i);
+    } else {
+      _regsValid &= ~(1 << (reg + i));
+    }
+  }
+  return true;
+}
+
+bool Adafruit_TSL2591::writeBlock(uint8_t reg, const uint8_t *buffer,
+                                  uint8_t len) {
+  return transfer(reg, buffer, len, NULL, 0);
+}
+
+void Adafruit_TSL2591::pause(uint32_t ms) {
+  TSL2591_STAT(_stats.waitMs += ms);
+  delay(ms);
+}
+
+bool Adafruit_TSL2591::write8(uint8_t reg, uint8_t value) {
+  return transfer(reg, &value, 1, NULL, 0);
 }
 
-void Adafruit_TSL2591::write8(uint8_t reg) {
-  uint8_t buffer[1];
-  buffer[0] = reg;
-  i2c_dev->write(buffer, 1);
+bool Adafruit_TSL2591::write8(uint8_t reg) {
+  return transfer(reg, NULL, 0, NULL, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reports a finished bus transaction to the bus monitor, if any
+    @param  start micros() before the transaction was issued
+    @param  command Command byte that started the transaction, or
+   TSL2591_ADDRESS_PROBE
+    @param  written Bytes written after the command byte
+    @param  read Bytes read back
+    @param  ok Result reported by the I2C device
+*/
+/**************************************************************************/
+void Adafruit_TSL2591::recordTransaction(uint32_t start, uint8_t command,
+                                         uint8_t written, uint8_t read,
+                                         bool ok) {
+  TSL2591_STAT(_stats.transactions++);
+  TSL2591_STAT(_stats.bytesWritten +=
+               (command != TSL2591_ADDRESS_PROBE) + written);
+  TSL2591_STAT(_stats.bytesRead += read);
+  TSL2591_STAT(_stats.i2cErrors += !ok);
+
+  if (!_busMonitor) {
+    return;
+  }
+
+  tsl2591Transaction_t t;
+  t.timestamp = micros();
+  t.duration = t.timestamp - start;
+  t.command = command;
+  t.written = written;
+  t.read = read;
+  t.ok = ok;
+  _busMonitor(&t, _busMonitorContext);
 }
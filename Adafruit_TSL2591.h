@@ -23,6 +23,35 @@
 #include <Adafruit_Sensor.h>
 #include <Arduino.h>
 
+#include "Adafruit_TSL2591_Lux.h"
+#include "Adafruit_TSL2591_Samples.h"
+
+#ifndef TSL2591_ENABLE_STATS
+#define TSL2591_ENABLE_STATS                                                   \
+  (0) ///< Build flag: set to 1 for the library and the sketch alike (e.g. -D
+      ///< in the build flags) to count in Adafruit_TSL2591::getStats()
+#endif
+
+#if TSL2591_ENABLE_STATS
+#define TSL2591_STAT(x) (x) ///< Updates a stats counter
+#define TSL2591_STATS_CHECK                                                    \
+  tsl2591_library_built_with_TSL2591_ENABLE_STATS_1 ///< See below
+#else
+#define TSL2591_STAT(x) ///< Stats are compiled out
+#define TSL2591_STATS_CHECK                                                    \
+  tsl2591_library_built_with_TSL2591_ENABLE_STATS_0 ///< See below
+#endif
+
+/// Defined by the library for the flag it was built with only. Every file
+/// that includes this header references it, so a sketch built with the
+/// other setting (and so another class layout) fails to link instead of
+/// running with a mismatched layout
+extern const uint8_t TSL2591_STATS_CHECK;
+#ifdef __GNUC__
+static const uint8_t *const tsl2591StatsCheck __attribute__((used)) =
+    &TSL2591_STATS_CHECK;
+#endif
+
 #define TSL2591_VISIBLE (2)      ///< (channel 0) - (channel 1)
 #define TSL2591_INFRARED (1)     ///< channel 1
 #define TSL2591_FULLSPECTRUM (0) ///< channel 0
@@ -32,8 +61,14 @@
 #define TSL2591_COMMAND_BIT                                                    \
   (0xA0) ///< 1010 0000: bits 7 and 5 for 'command normal'
 
+#define TSL2591_ADDRESS_PROBE                                                  \
+  (0x00) ///< Command reported to a bus monitor for the address probe in
+         ///< begin(), an empty write with nothing after the address
+
 ///! Special Function Command for "Clear ALS and no persist ALS interrupt"
 #define TSL2591_CLEAR_INT (0xE7)
+///! Special Function Command for "Clear ALS interrupt"
+#define TSL2591_CLEAR_ALS_INT (0xE6)
 ///! Special Function Command for "Interrupt set - forces an interrupt"
 #define TSL2591_TEST_INT (0xE4)
 
@@ -52,10 +87,36 @@
   (0x80) ///< No Persist Interrupt Enable. When asserted NP Threshold conditions
          ///< will generate an interrupt, bypassing the persist filter
 
-#define TSL2591_LUX_DF (408.0F)   ///< Lux cooefficient
-#define TSL2591_LUX_COEFB (1.64F) ///< CH0 coefficient
-#define TSL2591_LUX_COEFC (0.59F) ///< CH1 coefficient A
-#define TSL2591_LUX_COEFD (0.86F) ///< CH2 coefficient B
+#define TSL2591_STATUS_AVALID                                                  \
+  (0x01) ///< ALS Valid. Set once an integration cycle has completed since AEN
+         ///< was asserted.
+#define TSL2591_STATUS_AINT (0x10)  ///< ALS Interrupt flag
+#define TSL2591_STATUS_NPINTR (0x20) ///< No-persist Interrupt flag
+
+#define TSL2591_POLL_INTERVAL_MS                                               \
+  (2) ///< Delay between AVALID polls once the nominal integration time is up
+
+#define TSL2591_AUTORANGE_LOW                                                  \
+  (3000) ///< Default lower edge of the auto-range CH0 hysteresis band
+#define TSL2591_AUTORANGE_HIGH                                                 \
+  (30000) ///< Default upper edge of the auto-range CH0 hysteresis band
+
+#define TSL2591_SETTLE_THRESHOLD                                               \
+  (10) ///< Default CH0 change (percent) that triggers a second sample in
+       ///< TSL2591_SETTLE_ADAPTIVE
+
+#define TSL2591_TRACKING_MIN_BAND                                              \
+  (8) ///< Smallest half width of the tracking window, in counts
+
+#define TSL2591_RETRIES (2) ///< Default retries for a failed transaction
+#define TSL2591_RETRY_BACKOFF_US                                               \
+  (200) ///< Default wait before the first retry, doubled for each retry
+#define TSL2591_RETRY_DEADLINE_MS                                              \
+  (5) ///< Default limit on the time one transaction may spend retrying
+#define TSL2591_HEALTH_FAIL_COUNT                                              \
+  (3) ///< Consecutive failed transactions that mark a device as failed
+#define TSL2591_STATE_VERSION                                                  \
+  (1) ///< Layout of tsl2591State_t, blobs with another version are rejected
 
 /// TSL2591 Register map
 enum {
@@ -122,6 +183,128 @@ typedef enum {
   TSL2591_GAIN_MAX = 0x30,  /// max gain (9876x)
 } tsl2591Gain_t;
 
+/// Enumeration for the action taken by the auto-range engine
+typedef enum {
+  TSL2591_AUTORANGE_HOLD = 0,      // Reading inside the band, settings kept
+  TSL2591_AUTORANGE_UP = 1,        // Too dark, sensitivity increased
+  TSL2591_AUTORANGE_DOWN = 2,      // Too bright, sensitivity decreased
+  TSL2591_AUTORANGE_SATURATED = 3, // Saturated, least sensitive setting used
+} tsl2591AutoRangeAction_t;
+
+/// Enumeration for the getEvent() settle policy
+typedef enum {
+  TSL2591_SETTLE_DOUBLE = 0,   // Always sample twice (early silicon)
+  TSL2591_SETTLE_SINGLE = 1,   // Always sample once
+  TSL2591_SETTLE_ADAPTIVE = 2, // Sample again only if the level jumped
+} tsl2591Settle_t;
+
+/// Result codes returned by the read*() APIs
+typedef enum {
+  TSL2591_OK = 0,            // Success
+  TSL2591_ERR_NOT_FOUND = 1, // No TSL2591 answered (ID check failed)
+  TSL2591_ERR_BUS = 2,       // An I2C transaction failed after all retries
+  TSL2591_ERR_TIMEOUT = 3,   // The conversion did not complete in time
+  TSL2591_ERR_SATURATED = 4, // Data read, but a channel hit its count limit
+  TSL2591_ERR_RESET = 5,     // The chip lost our settings, e.g. a brown-out
+} tsl2591Result_t;
+
+/// Enumeration for the health of the bus link to a device
+typedef enum {
+  TSL2591_HEALTH_OK = 0,       // The last transaction succeeded
+  TSL2591_HEALTH_DEGRADED = 1, // Recent transactions failed
+  TSL2591_HEALTH_FAILED = 2,   // TSL2591_HEALTH_FAIL_COUNT in a row failed
+} tsl2591Health_t;
+
+/// Channel sums over several conversions, see startOversampling()
+typedef struct {
+  uint32_t ch0;    ///< Sum of channel 0 (IR+Visible) counts
+  uint32_t ch1;    ///< Sum of channel 1 (IR) counts
+  uint8_t count;   ///< Number of conversions summed
+  uint8_t control; ///< CONTROL value (gain | integration) the sums are at
+  bool overflow;   ///< A conversion hit the count limit (saturated)
+} tsl2591Oversample_t;
+
+/// Enumeration for the power state begin(config) leaves the ALS in
+typedef enum {
+  TSL2591_POWER_OFF = 0,        // Powered down, conversions run on demand
+  TSL2591_POWER_CONTINUOUS = 1, // Powered up, as after startContinuous()
+} tsl2591Power_t;
+
+/// Complete sensor configuration, applied by begin(config) in one go
+typedef struct {
+  tsl2591Gain_t gain;                   ///< Analog gain
+  tsl2591IntegrationTime_t integration; ///< Integration time
+  tsl2591Persist_t persist;             ///< ALS interrupt persist filter
+  uint16_t lowerThreshold;   ///< ALS (persist) interrupt low threshold
+  uint16_t upperThreshold;   ///< ALS (persist) interrupt high threshold
+  uint16_t npLowerThreshold; ///< No-persist interrupt low threshold
+  uint16_t npUpperThreshold; ///< No-persist interrupt high threshold
+  tsl2591Power_t power;      ///< Power state to leave the ALS in
+} tsl2591Config_t;
+
+/// Every register from ENABLE to the channel data, see readSnapshot()
+typedef struct {
+  uint8_t enable;            ///< ENABLE register
+  uint8_t control;           ///< CONTROL register (gain | integration)
+  uint16_t lowerThreshold;   ///< ALS (persist) interrupt low threshold
+  uint16_t upperThreshold;   ///< ALS (persist) interrupt high threshold
+  uint16_t npLowerThreshold; ///< No-persist interrupt low threshold
+  uint16_t npUpperThreshold; ///< No-persist interrupt high threshold
+  uint8_t persist;           ///< PERSIST register
+  uint8_t pid;               ///< PID register (package identification)
+  uint8_t id;                ///< ID register, 0x50 for a TSL2591
+  uint8_t status;            ///< STATUS register
+  uint16_t ch0;              ///< Channel 0 (IR+Visible) data
+  uint16_t ch1;              ///< Channel 1 (IR) data
+} tsl2591Snapshot_t;
+
+/// Driver state saved by exportState(), small enough for retained memory
+typedef struct {
+  uint32_t luxCalibration; ///< setLuxCalibration() factor in Q16
+  uint8_t version;         ///< TSL2591_STATE_VERSION
+  uint8_t address;         ///< I2C address of the sensor
+  uint8_t continuous;      ///< Non-zero if in continuous mode
+  uint8_t regs[TSL2591_REGISTER_PERSIST_FILTER + 1]; ///< ENABLE..PERSIST
+  uint8_t check; ///< Checksum over the fields above
+} tsl2591State_t;
+
+/// Last decision made by the auto-range engine, exposed for tuning
+typedef struct {
+  uint16_t ch0;       ///< CH0 counts the decision was based on
+  uint32_t predicted; ///< Expected CH0 counts with the selected settings
+  tsl2591Gain_t gain; ///< Gain selected for the next conversion
+  tsl2591IntegrationTime_t integration; ///< Integration time selected
+  tsl2591AutoRangeAction_t action;      ///< What the engine did
+  uint8_t conversions; ///< Conversions used by getAutoRangedLuminosity()
+} tsl2591AutoRange_t;
+
+/// One I2C transaction, as reported to a bus monitor
+typedef struct {
+  uint32_t timestamp; ///< micros() when the transaction finished
+  uint32_t duration;  ///< micros() spent on the bus
+  uint8_t command;    ///< Command byte sent first (register or special fn),
+                      ///< or TSL2591_ADDRESS_PROBE
+  uint8_t written;    ///< Bytes written after the command byte
+  uint8_t read;       ///< Bytes read back
+  bool ok;            ///< False if the I2C device reported a failure
+} tsl2591Transaction_t;
+
+/// Hot path counters, see Adafruit_TSL2591::getStats()
+typedef struct {
+  uint32_t transactions; ///< I2C transactions issued
+  uint32_t bytesWritten; ///< Bytes written, including command bytes
+  uint32_t bytesRead;    ///< Bytes read back
+  uint32_t waitMs;       ///< Time spent blocked in delay() waiting on the ADC
+  uint32_t conversions;  ///< Channel data reads
+  uint32_t overflows;    ///< calculateLux() calls that hit the overflow path
+  uint32_t saturations;  ///< Readings at the analog or digital count limit
+  uint32_t i2cErrors;    ///< Transactions the I2C device reported as failed
+} tsl2591Stats_t;
+
+/// Callback that observes every I2C transaction issued by the driver
+typedef void (*tsl2591BusMonitor_t)(const tsl2591Transaction_t *transaction,
+                                    void *context);
+
 /**************************************************************************/
 /*!
     @brief  Class that stores state and functions for interacting with TSL2591
@@ -135,40 +318,240 @@ public:
 
   boolean begin(TwoWire *theWire, uint8_t addr = TSL2591_ADDR);
   boolean begin(uint8_t addr = TSL2591_ADDR);
+  boolean begin(Adafruit_I2CDevice *device);
+  boolean begin(const tsl2591Config_t *config, TwoWire *theWire = &Wire,
+                uint8_t addr = TSL2591_ADDR);
+  boolean resume(const tsl2591State_t *state, TwoWire *theWire = &Wire,
+                 bool verify = true);
+  bool exportState(tsl2591State_t *state);
   void enable(void);
   void disable(void);
 
   float calculateLux(uint16_t ch0, uint16_t ch1);
+  int32_t calculateLuxMilli(uint16_t ch0, uint16_t ch1);
+  static int32_t calculateLuxMilli(uint16_t ch0, uint16_t ch1,
+                                   tsl2591Gain_t gain,
+                                   tsl2591IntegrationTime_t integration);
+  static int32_t calculateLuxMilli(uint16_t ch0, uint16_t ch1, uint32_t k);
+  static int32_t calculateLuxMilli(const tsl2591Oversample_t *sums,
+                                   float calibration = 1.0F);
+  static void calculateLuxMilli(const uint32_t *lum, int32_t *mlux,
+                                size_t count, tsl2591Gain_t gain,
+                                tsl2591IntegrationTime_t integration,
+                                float calibration = 1.0F);
+  void setLuxCalibration(float factor);
+  float getLuxCalibration(void);
+
+  /************************************************************************/
+  /*!
+      @brief  Count limit of a channel. At 100ms the ADC saturates at
+     TSL2591_MAX_COUNT_100MS, well below the 16 bit register limit, so a
+     reading at or above the value returned here is clipped and its lux
+     would be wrong.
+      @param  integration {@link tsl2591IntegrationTime_t} integration time
+     the data is taken with
+      @returns Lowest saturated count
+  */
+  /************************************************************************/
+  static constexpr uint16_t
+  saturationLimit(tsl2591IntegrationTime_t integration) {
+    return (integration == TSL2591_INTEGRATIONTIME_100MS)
+               ? TSL2591_MAX_COUNT_100MS
+               : TSL2591_MAX_COUNT;
+  }
+  bool isSaturated(uint32_t lum);
+
+  /************************************************************************/
+  /*!
+      @brief  Milli-lux per count in Q16, 1000 * DF / (ATIME * AGAIN) * 2^16,
+     i.e. the reciprocal of CPL (counts per lux), evaluated at compile time
+      @param  gain {@link tsl2591Gain_t} gain the data is taken with
+      @param  integration {@link tsl2591IntegrationTime_t} integration time
+     the data is taken with
+      @returns Lux factor for calculateLuxMilli(ch0, ch1, k)
+  */
+  /************************************************************************/
+  static constexpr uint32_t luxFactor(tsl2591Gain_t gain,
+                                      tsl2591IntegrationTime_t integration) {
+    return tsl2591LuxFactor(gain | integration);
+  }
+
   void setGain(tsl2591Gain_t gain);
   void setTiming(tsl2591IntegrationTime_t integration);
   uint16_t getLuminosity(uint8_t channel);
   uint32_t getFullLuminosity();
 
+  // Result code variants
+  tsl2591Result_t readFullLuminosity(uint32_t *lum);
+  tsl2591Result_t readLux(float *lux);
+  tsl2591Result_t readStatus(uint8_t *status);
+  void setRetryPolicy(uint8_t retries,
+                      uint16_t backoffUs = TSL2591_RETRY_BACKOFF_US,
+                      uint16_t deadlineMs = TSL2591_RETRY_DEADLINE_MS);
+  tsl2591Health_t getHealth(void);
+  tsl2591Result_t readSnapshot(tsl2591Snapshot_t *snapshot);
+  tsl2591Result_t verifyState(tsl2591Snapshot_t *snapshot = NULL);
+  tsl2591Result_t restoreState(void);
+
+  // Non-blocking conversion
+  void startConversion(void);
+  boolean isReady(void);
+  uint32_t readResult(void);
+  tsl2591Result_t readResult(uint32_t *lum);
+
+  // Continuous measurement
+  void startContinuous(void);
+  void stopContinuous(void);
+  boolean isContinuous(void);
+  uint32_t getSequence(void);
+  uint32_t getLatestLuminosity(uint32_t *sequence = NULL);
+
+  // Oversampling
+  void startOversampling(uint8_t decimation);
+  void stopOversampling(void);
+  bool pollOversampled(tsl2591Oversample_t *sums);
+  tsl2591Result_t readOversampled(uint8_t count, tsl2591Oversample_t *sums);
+
+  // Sample history
+  void setSampleBuffer(Adafruit_TSL2591_SampleBuffer *buffer);
+
+  // Interrupt driven sampling
+  void startDataReadyInterrupt(Adafruit_TSL2591_SampleQueue *queue);
+  void stopDataReadyInterrupt(void);
+  void startTrackingInterrupt(uint8_t bandPercent,
+                              tsl2591Persist_t persist = TSL2591_PERSIST_ANY,
+                              Adafruit_TSL2591_SampleQueue *queue = NULL);
+  void handleInterrupt(void);
+  bool serviceInterrupt(void);
+
   tsl2591IntegrationTime_t getTiming();
   tsl2591Gain_t getGain();
 
+  // Auto-ranging
+  void setAutoRangeBand(uint16_t low, uint16_t high);
+  bool autoRange(uint16_t ch0);
+  uint32_t getAutoRangedLuminosity(uint8_t maxConversions = 4);
+  void getAutoRangeDecision(tsl2591AutoRange_t *decision);
+
   // Interrupt
   void clearInterrupt(void);
   void registerInterrupt(uint16_t lowerThreshold, uint16_t upperThreshold,
                          tsl2591Persist_t persist);
+  void registerInterrupt(uint16_t lowerThreshold, uint16_t upperThreshold,
+                         uint16_t npLowerThreshold, uint16_t npUpperThreshold,
+                         tsl2591Persist_t persist);
   uint8_t getStatus();
 
   /* Unified Sensor API Functions */
   bool getEvent(sensors_event_t *);
   void getSensor(sensor_t *);
+  void setSettlePolicy(tsl2591Settle_t policy,
+                       uint8_t thresholdPercent = TSL2591_SETTLE_THRESHOLD);
+  tsl2591Settle_t getSettlePolicy(void);
+
+  // Diagnostics
+  void setBusMonitor(tsl2591BusMonitor_t monitor, void *context = NULL);
+#if TSL2591_ENABLE_STATS
+  bool getStats(tsl2591Stats_t *stats);
+  void resetStats(void);
+#endif
 
 private:
+  template <tsl2591Gain_t, tsl2591IntegrationTime_t, uint8_t>
+  friend class Adafruit_TSL2591_Fixed;
+
   Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  TwoWire *_wire = NULL;              ///< Bus the owned i2c_dev was built on
+  bool _ownsI2cDev = false;           ///< i2c_dev was created by begin()
+  alignas(Adafruit_I2CDevice) uint8_t
+      _i2cStorage[sizeof(Adafruit_I2CDevice)]; ///< In place i2c_dev storage
 
-  void write8(uint8_t r);
-  void write8(uint8_t r, uint8_t v);
+  void attach(TwoWire *theWire, uint8_t addr);
+  boolean probe(const tsl2591Config_t *config = NULL);
+  void releaseI2CDevice(void);
+
+  bool write8(uint8_t r);
+  bool write8(uint8_t r, uint8_t v);
   uint16_t read16(uint8_t reg);
   uint8_t read8(uint8_t reg);
+  static bool readRegisters(Adafruit_I2CDevice *device, uint8_t reg,
+                            uint8_t *buffer, uint8_t len);
+  static bool writeRegisters(Adafruit_I2CDevice *device, uint8_t reg,
+                             const uint8_t *buffer, uint8_t len);
+  bool transfer(uint8_t reg, const uint8_t *out, uint8_t outLen, uint8_t *in,
+                uint8_t inLen);
+  bool readBlock(uint8_t reg, uint8_t *buffer, uint8_t len);
+  bool writeBlock(uint8_t reg, const uint8_t *buffer, uint8_t len);
+  void setControl(tsl2591Gain_t gain, tsl2591IntegrationTime_t integration);
+  bool updateRegister(uint8_t reg, uint8_t value);
+  bool updateRegisters(uint8_t reg, const uint8_t *values, uint8_t len);
+  tsl2591Result_t fetchResult(uint32_t *lum, uint8_t *status);
+  tsl2591Result_t readSnapshot(tsl2591Snapshot_t *snapshot, uint8_t *raw);
+  bool checkRegisters(const uint8_t *raw);
+  bool restoreRegisters(void);
+  uint32_t luxK(void);
+  static uint64_t luxFormula(uint32_t ch0, uint32_t ch1, uint8_t count);
+  void accumulate(uint32_t lum);
+  bool needsSettling(uint32_t lum);
+  static bool eventReading(tsl2591Result_t result);
+  void pause(uint32_t ms);
+  void retrack(uint16_t ch0);
+  uint8_t continuousPersist(uint8_t persist);
+  void recordTransaction(uint32_t start, uint8_t command, uint8_t written,
+                         uint8_t read, bool ok);
 
   tsl2591IntegrationTime_t _integration;
   tsl2591Gain_t _gain;
   int32_t _sensorID;
   uint8_t _addr;
+  uint32_t _conversionStart;
+  uint32_t _sequence;         ///< New conversions read in continuous mode
+  uint8_t _continuousPersist; ///< Persist filter to put back on disable()
+  boolean _continuous;
+
+  // Shadow copy of ENABLE..PERSIST, bit n of _regsValid is set when _regs[n]
+  // is known to match the chip
+  uint8_t _regs[TSL2591_REGISTER_PERSIST_FILTER + 1];
+  uint16_t _regsValid;
+
+  uint16_t _autoRangeLow;
+  uint16_t _autoRangeHigh;
+  tsl2591AutoRange_t _autoRange;
+
+  tsl2591Settle_t _settlePolicy;
+  uint8_t _settleThreshold;
+  uint32_t _lastLum;
+  uint8_t _lastControl;
+
+  tsl2591BusMonitor_t _busMonitor;
+  void *_busMonitorContext;
+
+  Adafruit_TSL2591_SampleBuffer *_samples;
+  Adafruit_TSL2591_SampleQueue *_queue;
+  volatile uint8_t _interruptsRaised; ///< Only written by handleInterrupt()
+  uint8_t _interruptsServiced;        ///< Only written by serviceInterrupt()
+  uint8_t _trackingPercent;
+  tsl2591Persist_t _trackingPersist;
+  /// Thresholds and persist filter to put back when tracking stops
+  uint8_t _trackingSaved[TSL2591_REGISTER_PERSIST_FILTER -
+                         TSL2591_REGISTER_THRESHOLD_AILTL + 1];
+#if TSL2591_ENABLE_STATS
+  tsl2591Stats_t _stats;
+#endif
+
+  uint32_t _luxCalibration; ///< Lux scale factor in Q16
+  uint32_t _luxK;           ///< Calibrated luxFactor() for _luxControl
+  uint8_t _luxControl;      ///< Settings _luxK is for, 0xFF if stale
+
+  tsl2591Oversample_t _accum;
+  uint8_t _decimation;
+
+  uint8_t _retries;
+  uint16_t _retryBackoffUs;
+  uint16_t _retryDeadlineMs;
+  uint8_t _consecutiveErrors;
+  bool _busError;
+  bool _verifyPending; ///< Check the chip state on the next readResult()
 
   boolean _initialized;
 };
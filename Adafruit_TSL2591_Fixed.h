@@ -0,0 +1,277 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Fixed.h
+
+    TSL2591 driver for deployments that never change gain or integration
+    time. Both are template parameters, checked at compile time, and the
+    lux factor is a compile time constant, so there are no settings fields,
+    no lookup tables and no branching on the settings at runtime. The lux
+    formula is a template parameter too, so one sketch can compare them.
+    Register access goes through the same code as Adafruit_TSL2591.
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+*/
+/**************************************************************************/
+
+#ifndef _TSL2591_FIXED_H_
+#define _TSL2591_FIXED_H_
+
+#include "Adafruit_TSL2591.h"
+
+/**************************************************************************/
+/*!
+    @brief  TSL2591 driver with gain and integration time fixed at compile
+   time. The I2C device is held in place, the heap is never used.
+    @tparam Gain {@link tsl2591Gain_t} gain used for every conversion
+    @tparam Integration {@link tsl2591IntegrationTime_t} integration time
+   used for every conversion
+    @tparam Algorithm Lux formula, one of the TSL2591_LUX_ALGORITHM values
+*/
+/**************************************************************************/
+template <tsl2591Gain_t Gain, tsl2591IntegrationTime_t Integration,
+          uint8_t Algorithm = TSL2591_LUX_ALGORITHM>
+class Adafruit_TSL2591_Fixed {
+  static_assert(Gain == TSL2591_GAIN_LOW || Gain == TSL2591_GAIN_MED ||
+                    Gain == TSL2591_GAIN_HIGH || Gain == TSL2591_GAIN_MAX,
+                "Gain must be one of the tsl2591Gain_t values");
+  static_assert(Integration >= TSL2591_INTEGRATIONTIME_100MS &&
+                    Integration <= TSL2591_INTEGRATIONTIME_600MS,
+                "Integration must be one of the tsl2591IntegrationTime_t "
+                "values");
+  static_assert(Algorithm <= TSL2591_LUX_ALT2,
+                "Algorithm must be one of the TSL2591_LUX_ALGORITHM values");
+
+public:
+  /// CONTROL register value
+  static constexpr uint8_t control = Integration | Gain;
+  /// Nominal conversion time in milliseconds
+  static constexpr uint16_t conversionMs = (Integration + 1) * 100;
+  /// Lowest saturated count, see Adafruit_TSL2591::saturationLimit()
+  static constexpr uint16_t saturationLimit =
+      Adafruit_TSL2591::saturationLimit(Integration);
+  /// Lux factor, see Adafruit_TSL2591::luxFactor()
+  static constexpr uint32_t luxFactor =
+      Adafruit_TSL2591::luxFactor(Gain, Integration);
+
+  /************************************************************************/
+  /*!
+      @brief  Instantiates a new driver, no bus traffic happens until begin()
+      @param  theWire a reference to TwoWire instance
+      @param  addr The I2C adress of the sensor (Default 0x29)
+  */
+  /************************************************************************/
+  Adafruit_TSL2591_Fixed(TwoWire *theWire = &Wire, uint8_t addr = TSL2591_ADDR)
+      : _dev(addr, theWire) {}
+
+  /************************************************************************/
+  /*!
+      @brief  Identifies the chip, loads the settings and powers it down
+      @returns True if a TSL2591 is found, false on any failure
+  */
+  /************************************************************************/
+  bool begin(void) {
+    if (!_dev.begin()) {
+      return false;
+    }
+
+    uint8_t id = 0;
+    Adafruit_TSL2591::readRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_ID, &id, 1);
+    if (id != 0x50) {
+      return false;
+    }
+
+    // ENABLE and CONTROL are adjacent, power down and set up in one write
+    uint8_t buffer[2] = {TSL2591_ENABLE_POWEROFF, control};
+    return Adafruit_TSL2591::writeRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE, buffer, 2);
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Powers up the ALS and starts a conversion, without waiting
+      @returns True if the I2C write succeeded
+  */
+  /************************************************************************/
+  bool startConversion(void) {
+    uint8_t enable = TSL2591_ENABLE_POWERON | TSL2591_ENABLE_AEN;
+    return Adafruit_TSL2591::writeRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE, &enable, 1);
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Checks whether the conversion started by startConversion()
+     has completed
+      @returns True if channel data is valid, false if not yet or if the
+     status could not be read
+  */
+  /************************************************************************/
+  bool isReady(void) {
+    uint8_t status = 0;
+    Adafruit_TSL2591::readRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS, &status,
+        1);
+    return status & TSL2591_STATUS_AVALID;
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Reads both channels in one transaction and powers the ALS down
+      @returns 32-bit raw count where high word is IR, low word is
+     IR+Visible, or 0 on a bus error
+  */
+  /************************************************************************/
+  uint32_t readResult(void) {
+    uint32_t x;
+    readResult(&x);
+    return x;
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Reads both channels in one transaction and powers the ALS
+     down, reporting whether the read worked. The power down is attempted
+     even if the read failed.
+      @param  lum Set to the 32-bit raw count where high word is IR, low
+     word is IR+Visible, 0 on error
+      @returns TSL2591_OK or TSL2591_ERR_BUS
+  */
+  /************************************************************************/
+  tsl2591Result_t readResult(uint32_t *lum) {
+    uint8_t buffer[4] = {0, 0, 0, 0};
+    bool ok = Adafruit_TSL2591::readRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_CHAN0_LOW, buffer, 4);
+    if (!powerDown() || !ok) {
+      *lum = 0;
+      return TSL2591_ERR_BUS;
+    }
+
+    *lum = (uint32_t)buffer[3] << 24 | (uint32_t)buffer[2] << 16 |
+           (uint32_t)buffer[1] << 8 | buffer[0];
+    return TSL2591_OK;
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Runs a conversion and reads both channels, blocking for about
+     conversionMs
+      @returns 32-bit raw count where high word is IR, low word is
+     IR+Visible, or 0 if the conversion did not complete (see
+     readFullLuminosity() for the cause)
+  */
+  /************************************************************************/
+  uint32_t getFullLuminosity(void) {
+    uint32_t x;
+    readFullLuminosity(&x);
+    return x;
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Runs a conversion and reads both channels, blocking for about
+     conversionMs, and reports what went wrong if anything. The ALS is
+     powered down again on every path.
+      @param  lum Set to the 32-bit raw count where high word is IR, low
+     word is IR+Visible, 0 on error
+      @returns TSL2591_OK, TSL2591_ERR_BUS or TSL2591_ERR_TIMEOUT
+  */
+  /************************************************************************/
+  tsl2591Result_t readFullLuminosity(uint32_t *lum) {
+    *lum = 0;
+    if (!startConversion()) {
+      powerDown();
+      return TSL2591_ERR_BUS;
+    }
+    delay(conversionMs);
+
+    uint32_t start = millis();
+    for (;;) {
+      uint8_t status = 0;
+      if (!Adafruit_TSL2591::readRegisters(
+              &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_DEVICE_STATUS,
+              &status, 1)) {
+        powerDown();
+        return TSL2591_ERR_BUS;
+      }
+      if (status & TSL2591_STATUS_AVALID) {
+        return readResult(lum);
+      }
+      if (millis() - start > conversionMs / 5) {
+        powerDown();
+        return TSL2591_ERR_TIMEOUT;
+      }
+      delay(TSL2591_POLL_INTERVAL_MS);
+    }
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Calculates the visible Lux with the compile time lux factor
+     and formula
+      @param  ch0 Data from channel 0 (IR+Visible)
+      @param  ch1 Data from channel 1 (IR)
+      @returns Milli-lux, or -1 if saturated
+  */
+  /************************************************************************/
+  static int32_t calculateLuxMilli(uint16_t ch0, uint16_t ch1) {
+    if ((ch0 >= saturationLimit) || (ch1 >= saturationLimit)) {
+      return -1;
+    }
+    return tsl2591LuxMilli(luxCounts(ch0, ch1), luxFactor);
+  }
+
+  /************************************************************************/
+  /*!
+      @brief  Calculates the visible Lux, with the resolution and error
+     bound of Adafruit_TSL2591::calculateLux()
+      @param  ch0 Data from channel 0 (IR+Visible)
+      @param  ch1 Data from channel 1 (IR)
+      @returns Lux (or < 0 if saturated)
+  */
+  /************************************************************************/
+  static float calculateLux(uint16_t ch0, uint16_t ch1) {
+    if ((ch0 >= saturationLimit) || (ch1 >= saturationLimit)) {
+      return -1;
+    }
+    return tsl2591LuxFloat(luxCounts(ch0, ch1), luxFactor);
+  }
+
+private:
+  /// Powers the ALS down, true if the I2C write succeeded
+  bool powerDown(void) {
+    uint8_t enable = TSL2591_ENABLE_POWEROFF;
+    return Adafruit_TSL2591::writeRegisters(
+        &_dev, TSL2591_COMMAND_BIT | TSL2591_REGISTER_ENABLE, &enable, 1);
+  }
+
+  /// The compile time formula, 16.16 fixed point counts
+  static uint64_t luxCounts(uint16_t ch0, uint16_t ch1) {
+    return (Algorithm == TSL2591_LUX_AMS)    ? tsl2591LuxDual(ch0, ch1)
+           : (Algorithm == TSL2591_LUX_ALT2) ? tsl2591LuxAlt2(ch0, ch1)
+                                             : tsl2591LuxAlt1(ch0, ch1);
+  }
+
+  Adafruit_I2CDevice _dev;
+};
+
+template <tsl2591Gain_t Gain, tsl2591IntegrationTime_t Integration,
+          uint8_t Algorithm>
+constexpr uint8_t
+    Adafruit_TSL2591_Fixed<Gain, Integration, Algorithm>::control;
+template <tsl2591Gain_t Gain, tsl2591IntegrationTime_t Integration,
+          uint8_t Algorithm>
+constexpr uint16_t
+    Adafruit_TSL2591_Fixed<Gain, Integration, Algorithm>::conversionMs;
+template <tsl2591Gain_t Gain, tsl2591IntegrationTime_t Integration,
+          uint8_t Algorithm>
+constexpr uint16_t
+    Adafruit_TSL2591_Fixed<Gain, Integration, Algorithm>::saturationLimit;
+template <tsl2591Gain_t Gain, tsl2591IntegrationTime_t Integration,
+          uint8_t Algorithm>
+constexpr uint32_t
+    Adafruit_TSL2591_Fixed<Gain, Integration, Algorithm>::luxFactor;
+
+#endif
@@ -0,0 +1,624 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Lux.cpp
+
+    Integer lux formulas and batch lux conversion for the TSL2591, with no
+    Arduino or bus dependency
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591_Lux.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TSL2591_BATCH_X86 (1) ///< SSE4.2 and AVX2 paths, picked at runtime
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define TSL2591_BATCH_ARM (1) ///< NEON path, always there on AArch64
+#include <arm_neon.h>
+#endif
+
+/// One row of tsl2591BatchFactor, the lux factor for each integration time
+#define TSL2591_BATCH_ROW(gain)                                                \
+  {                                                                            \
+    tsl2591LuxFactor((gain) | 0), tsl2591LuxFactor((gain) | 1),                \
+        tsl2591LuxFactor((gain) | 2), tsl2591LuxFactor((gain) | 3),            \
+        tsl2591LuxFactor((gain) | 4), tsl2591LuxFactor((gain) | 5),            \
+  }
+
+/// Lux reciprocal table, indexed by [gain >> 4][integration]
+static const uint32_t tsl2591BatchFactor[4][6] = {
+    TSL2591_BATCH_ROW(0x00),
+    TSL2591_BATCH_ROW(0x10),
+    TSL2591_BATCH_ROW(0x20),
+    TSL2591_BATCH_ROW(0x30),
+};
+
+// The vector paths multiply 32 bit lanes
+static_assert((tsl2591Q16(TSL2591_LUX_COEFB) >> 32) == 0, "COEFB too large");
+static_assert((tsl2591Q16(TSL2591_LUX_COEFC) >> 32) == 0, "COEFC too large");
+static_assert((tsl2591Q16(TSL2591_LUX_COEFD) >> 32) == 0, "COEFD too large");
+static_assert((tsl2591Q16(TSL2591_LUX_COEFE) >> 32) == 0, "COEFE too large");
+
+/// Per call constants of a batch conversion
+typedef struct {
+  uint64_t saturation; ///< Largest 16.16 result that is not 0x7FFFFFFF
+  uint32_t k;          ///< Calibrated lux factor
+  uint16_t limit;      ///< Lowest saturated count
+  uint8_t algorithm;   ///< TSL2591_LUX_ALGORITHM value
+} tsl2591Batch_t;
+
+/**************************************************************************/
+/*!
+    @brief  Folds a calibration factor into a lux factor, so calibrated
+   readings cost nothing extra per sample
+    @param  k tsl2591LuxFactor() for the settings
+    @param  calibration Q16 scale factor, 65536 is uncalibrated
+    @returns Calibrated lux factor, saturating at 32 bits
+*/
+/**************************************************************************/
+uint32_t tsl2591Calibrate(uint32_t k, uint32_t calibration) {
+  uint64_t c = ((uint64_t)k * calibration + 0x8000) >> 16;
+  return (c > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)c;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Converts a calibration factor to Q16
+    @param  factor Scale factor, e.g. the glass attenuation
+    @returns Q16 scale factor, clamped to 0..65535.99
+*/
+/**************************************************************************/
+uint32_t tsl2591CalibrationQ16(float factor) {
+  if (!(factor > 0)) {
+    return 0;
+  }
+  if (factor >= 65536.0F) {
+    return 0xFFFFFFFFUL;
+  }
+  return (uint32_t)(factor * 65536.0F + 0.5F);
+}
+
+
+/************************************************************************/
+/*!
+    @brief  Original lux calculation, the larger of the two AMS equations
+   lux1 = (ch0 - B * ch1) / cpl and lux2 = (C * ch0 - D * ch1) / cpl
+    @param  ch0 Data from channel 0 (IR+Visible), not overflowed, or the sum
+   over count conversions
+    @param  ch1 Data from channel 1 (IR), not overflowed, or the sum over
+   count conversions
+    @param  count Conversions summed
+    @returns The numerator of the mean conversion, 16.16 fixed point counts
+*/
+/**************************************************************************/
+uint64_t tsl2591LuxDual(uint32_t ch0, uint32_t ch1, uint8_t count) {
+  int64_t n1 = ((int64_t)ch0 << 16) - tsl2591Q16(TSL2591_LUX_COEFB) * ch1;
+  int64_t n2 = tsl2591Q16(TSL2591_LUX_COEFC) * ch0 -
+               tsl2591Q16(TSL2591_LUX_COEFD) * ch1;
+  int64_t n = (n1 > n2) ? n1 : n2;
+  if (n <= 0) {
+    return 0;
+  }
+
+  // The formula is linear, so the mean of the sums is the sums' result
+  // divided by count. The mean conversion is <= 65535, so it fits 16.16
+  return (count > 1) ? (uint64_t)n / count : (uint64_t)n;
+}
+
+/************************************************************************/
+/*!
+    @brief  Alternate lux calculation 1, the default
+   See: https://github.com/adafruit/Adafruit_TSL2591_Library/issues/14
+
+   Matches the float formula (ch0 - ch1) * (1 - ch1 / ch0) / cpl, including
+   its positive result (ch1 - ch0)^2 / ch0 / cpl when IR reads above full
+   spectrum. Where the float formula had no finite result, ch0 = 0 gives
+   TSL2591_LUX_INFINITE (it returned inf) or, in the dark with ch1 = 0 too,
+   0 (it returned NaN).
+    @param  ch0 Data from channel 0 (IR+Visible), not overflowed, or the sum
+   over count conversions
+    @param  ch1 Data from channel 1 (IR), not overflowed, or the sum over
+   count conversions
+    @param  count Conversions summed
+    @returns The numerator of the mean conversion, 16.16 fixed point counts,
+   or TSL2591_LUX_INFINITE past any int32 milli-lux result
+*/
+/**************************************************************************/
+uint64_t tsl2591LuxAlt1(uint32_t ch0, uint32_t ch1, uint8_t count) {
+  uint32_t d = (ch0 > ch1) ? ch0 - ch1 : ch1 - ch0;
+  if (!ch0) {
+    return d ? TSL2591_LUX_INFINITE : 0;
+  }
+
+  // lux = (ch0 - ch1) * (1 - (ch1 / ch0)) / cpl = (ch0 - ch1)^2 / ch0 / cpl
+  // With ch1 < ch0, (ch0 - ch1)^2 / ch0 <= ch0 - ch1 fits 16.16 fixed point.
+  // The formula scales linearly, so sums divided by count give the mean
+  uint64_t q;
+  if ((ch0 | ch1) <= 0xFFFF) {
+    // One conversion, 32 bit math is enough
+    uint32_t d2 = d * d;
+    q = ((uint64_t)(d2 / ch0) << 16) | (((d2 % ch0) << 16) / ch0);
+  } else {
+    uint64_t d2 = (uint64_t)d * d;
+    q = d2 / ch0;
+    if (q >> 47) {
+      // IR far above full spectrum, past the int32 range for any settings
+      return TSL2591_LUX_INFINITE;
+    }
+    q = (q << 16) | (((d2 % ch0) << 16) / ch0);
+  }
+  return (count > 1) ? q / count : q;
+}
+
+/************************************************************************/
+/*!
+    @brief  Alternate lux calculation 2, lux = (ch0 - E * ch1) / cpl
+    @param  ch0 Data from channel 0 (IR+Visible), not overflowed, or the sum
+   over count conversions
+    @param  ch1 Data from channel 1 (IR), not overflowed, or the sum over
+   count conversions
+    @param  count Conversions summed
+    @returns The numerator of the mean conversion, 16.16 fixed point counts
+*/
+/**************************************************************************/
+uint64_t tsl2591LuxAlt2(uint32_t ch0, uint32_t ch1, uint8_t count) {
+  int64_t n = ((int64_t)ch0 << 16) - tsl2591Q16(TSL2591_LUX_COEFE) * ch1;
+  if (n <= 0) {
+    return 0;
+  }
+
+  return (count > 1) ? (uint64_t)n / count : (uint64_t)n;
+}
+
+/************************************************************************/
+/*!
+    @brief  Scales a formula result to milli-lux, rounded. Results past the
+   int32 range saturate to 0x7FFFFFFF.
+    @param  q Formula result, 16.16 fixed point counts
+    @param  k tsl2591LuxFactor() for the settings the data was taken with
+    @returns Milli-lux
+*/
+/**************************************************************************/
+int32_t tsl2591LuxMilli(uint64_t q, uint32_t k) {
+  // Below 2^32 (the mean conversion is under 65536 counts) q * k fits
+  if ((q == TSL2591_LUX_INFINITE) ||
+      ((q >> 32) && k && (q > ((uint64_t)0x7FFFFFFF << 32) / k))) {
+    return 0x7FFFFFFF;
+  }
+  return (uint32_t)((q * k + 0x80000000UL) >> 32);
+}
+
+/************************************************************************/
+/*!
+    @brief  Scales a formula result to lux without rounding it to milli-lux
+    @param  q Formula result, 16.16 fixed point counts
+    @param  k tsl2591LuxFactor() for the settings the data was taken with
+    @returns Lux, 0x7FFFFFFF milli-lux where tsl2591LuxMilli() saturates on
+   TSL2591_LUX_INFINITE
+*/
+/**************************************************************************/
+float tsl2591LuxFloat(uint64_t q, uint32_t k) {
+  if (q == TSL2591_LUX_INFINITE) {
+    return 0x7FFFFFFF / 1000.0F;
+  }
+  // k is milli-lux per count in Q16, q is counts in Q16
+  return (float)q * ((float)k * (1.0F / (4294967296.0F * 1000.0F)));
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Batch conversion in plain C++, also the tail of the vector paths
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  batch Per call constants
+*/
+/**************************************************************************/
+static void tsl2591BatchScalar(const uint32_t *lum, int32_t *mlux,
+                               size_t count, const tsl2591Batch_t *batch) {
+  for (size_t i = 0; i < count; i++) {
+    uint16_t ch0 = lum[i] & 0xFFFF;
+    uint16_t ch1 = lum[i] >> 16;
+    if ((ch0 >= batch->limit) || (ch1 >= batch->limit)) {
+      mlux[i] = -1;
+      continue;
+    }
+    uint64_t q = (batch->algorithm == TSL2591_LUX_AMS)
+                     ? tsl2591LuxDual(ch0, ch1)
+                 : (batch->algorithm == TSL2591_LUX_ALT2)
+                     ? tsl2591LuxAlt2(ch0, ch1)
+                     : tsl2591LuxAlt1(ch0, ch1);
+    mlux[i] = tsl2591LuxMilli(q, batch->k);
+  }
+}
+
+// The vector paths keep one reading per 64 bit lane and follow the scalar
+// formulas step by step:
+// - AMS and ALT2 are two or three 32x32 bit multiplies and a subtraction.
+// - ALT1 divides (ch0 - ch1)^2 * 2^16 by ch0 in double precision. The
+//   dividend is below 2^48, so it is exact and the quotient Q is correctly
+//   rounded, off by at most Q * 2^-53 < 2^-5 / ch0. A fraction of Q is a
+//   multiple of 1 / ch0, so rounding never reaches the next integer and
+//   the floor of the double quotient is exact without a correction.
+// - The 16.16 result times k is two 32x32 bit multiplies, mod 2^64 like the
+//   scalar code, and saturation is one compare against a precomputed limit.
+// Integers below 2^52 move to and from double by adding the bit pattern
+// of 2^52, which SSE and AVX2 have no instruction for.
+
+#ifdef TSL2591_BATCH_X86
+#define TSL2591_MAGIC_BITS (0x4330000000000000LL) ///< 2^52 as a double
+#define TSL2591_MAGIC (4503599627370496.0)        ///< 2^52
+
+/**************************************************************************/
+/*!
+    @brief  Batch conversion with SSE4.2, two readings per vector
+    @tparam Algorithm TSL2591_LUX_ALGORITHM value
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  batch Per call constants
+*/
+/**************************************************************************/
+template <uint8_t Algorithm>
+__attribute__((target("sse4.2"))) static void
+tsl2591BatchSse42(const uint32_t *lum, int32_t *mlux, size_t count,
+                  const tsl2591Batch_t *batch) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi64x(1);
+  const __m128i low16 = _mm_set1_epi64x(0xFFFF);
+  const __m128i limit = _mm_set1_epi64x(batch->limit - 1);
+  const __m128i k = _mm_set1_epi64x(batch->k);
+  const __m128i half = _mm_set1_epi64x(0x80000000LL);
+  const __m128i saturation = _mm_set1_epi64x(batch->saturation);
+  const __m128i top = _mm_set1_epi64x(0x7FFFFFFF);
+  const __m128i magicBits = _mm_set1_epi64x(TSL2591_MAGIC_BITS);
+  const __m128d magic = _mm_set1_pd(TSL2591_MAGIC);
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i raw = _mm_cvtepu32_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lum + i)));
+    __m128i ch0 = _mm_and_si128(raw, low16);
+    __m128i ch1 = _mm_srli_epi64(raw, 16);
+    __m128i over =
+        _mm_or_si128(_mm_cmpgt_epi64(ch0, limit), _mm_cmpgt_epi64(ch1, limit));
+
+    __m128i q, infinite = zero;
+    if (Algorithm == TSL2591_LUX_AMS) {
+      __m128i n1 = _mm_sub_epi64(
+          _mm_slli_epi64(ch0, 16),
+          _mm_mul_epu32(ch1, _mm_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFB))));
+      __m128i n2 = _mm_sub_epi64(
+          _mm_mul_epu32(ch0, _mm_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFC))),
+          _mm_mul_epu32(ch1, _mm_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFD))));
+      q = _mm_blendv_epi8(n2, n1, _mm_cmpgt_epi64(n1, n2));
+      q = _mm_and_si128(q, _mm_cmpgt_epi64(q, zero));
+    } else if (Algorithm == TSL2591_LUX_ALT2) {
+      q = _mm_sub_epi64(
+          _mm_slli_epi64(ch0, 16),
+          _mm_mul_epu32(ch1, _mm_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFE))));
+      q = _mm_and_si128(q, _mm_cmpgt_epi64(q, zero));
+    } else {
+      __m128i d = _mm_sub_epi64(_mm_max_epu32(ch0, ch1),
+                                _mm_min_epu32(ch0, ch1));
+      __m128i d2 = _mm_mul_epu32(d, d);
+      __m128i dark = _mm_cmpeq_epi64(ch0, zero);
+      infinite = _mm_andnot_si128(_mm_cmpeq_epi64(d2, zero), dark);
+      __m128i divisor = _mm_or_si128(ch0, _mm_and_si128(dark, one));
+
+      __m128d x = _mm_div_pd(
+          _mm_mul_pd(
+              _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(d2, magicBits)), magic),
+              _mm_set1_pd(65536.0)),
+          _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(divisor, magicBits)),
+                     magic));
+      q = _mm_sub_epi64(
+          _mm_castpd_si128(_mm_add_pd(_mm_floor_pd(x), magic)), magicBits);
+    }
+
+    __m128i milli = _mm_add_epi64(
+        _mm_add_epi64(_mm_mul_epu32(q, k), half),
+        _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(q, 32), k), 32));
+    milli = _mm_srli_epi64(milli, 32);
+    milli = _mm_blendv_epi8(
+        milli, top,
+        _mm_or_si128(_mm_cmpgt_epi64(q, saturation), infinite));
+    milli = _mm_or_si128(milli, over);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(mlux + i),
+                     _mm_shuffle_epi32(milli, _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+  tsl2591BatchScalar(lum + i, mlux + i, count - i, batch);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Batch conversion with AVX2, four readings per vector
+    @tparam Algorithm TSL2591_LUX_ALGORITHM value
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  batch Per call constants
+*/
+/**************************************************************************/
+template <uint8_t Algorithm>
+__attribute__((target("avx2"))) static void
+tsl2591BatchAvx2(const uint32_t *lum, int32_t *mlux, size_t count,
+                 const tsl2591Batch_t *batch) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i low16 = _mm256_set1_epi64x(0xFFFF);
+  const __m256i limit = _mm256_set1_epi64x(batch->limit - 1);
+  const __m256i k = _mm256_set1_epi64x(batch->k);
+  const __m256i half = _mm256_set1_epi64x(0x80000000LL);
+  const __m256i saturation = _mm256_set1_epi64x(batch->saturation);
+  const __m256i top = _mm256_set1_epi64x(0x7FFFFFFF);
+  const __m256i magicBits = _mm256_set1_epi64x(TSL2591_MAGIC_BITS);
+  const __m256d magic = _mm256_set1_pd(TSL2591_MAGIC);
+  const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i raw = _mm256_cvtepu32_epi64(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lum + i)));
+    __m256i ch0 = _mm256_and_si256(raw, low16);
+    __m256i ch1 = _mm256_srli_epi64(raw, 16);
+    __m256i over = _mm256_or_si256(_mm256_cmpgt_epi64(ch0, limit),
+                                   _mm256_cmpgt_epi64(ch1, limit));
+
+    __m256i q, infinite = zero;
+    if (Algorithm == TSL2591_LUX_AMS) {
+      __m256i n1 = _mm256_sub_epi64(
+          _mm256_slli_epi64(ch0, 16),
+          _mm256_mul_epu32(ch1,
+                           _mm256_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFB))));
+      __m256i n2 = _mm256_sub_epi64(
+          _mm256_mul_epu32(ch0,
+                           _mm256_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFC))),
+          _mm256_mul_epu32(ch1,
+                           _mm256_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFD))));
+      q = _mm256_blendv_epi8(n2, n1, _mm256_cmpgt_epi64(n1, n2));
+      q = _mm256_and_si256(q, _mm256_cmpgt_epi64(q, zero));
+    } else if (Algorithm == TSL2591_LUX_ALT2) {
+      q = _mm256_sub_epi64(
+          _mm256_slli_epi64(ch0, 16),
+          _mm256_mul_epu32(ch1,
+                           _mm256_set1_epi64x(tsl2591Q16(TSL2591_LUX_COEFE))));
+      q = _mm256_and_si256(q, _mm256_cmpgt_epi64(q, zero));
+    } else {
+      __m256i d = _mm256_sub_epi64(_mm256_max_epu32(ch0, ch1),
+                                   _mm256_min_epu32(ch0, ch1));
+      __m256i d2 = _mm256_mul_epu32(d, d);
+      __m256i dark = _mm256_cmpeq_epi64(ch0, zero);
+      infinite = _mm256_andnot_si256(_mm256_cmpeq_epi64(d2, zero), dark);
+      __m256i divisor = _mm256_or_si256(ch0, _mm256_and_si256(dark, one));
+
+      __m256d x = _mm256_div_pd(
+          _mm256_mul_pd(
+              _mm256_sub_pd(
+                  _mm256_castsi256_pd(_mm256_or_si256(d2, magicBits)), magic),
+              _mm256_set1_pd(65536.0)),
+          _mm256_sub_pd(
+              _mm256_castsi256_pd(_mm256_or_si256(divisor, magicBits)),
+              magic));
+      q = _mm256_sub_epi64(
+          _mm256_castpd_si256(_mm256_add_pd(_mm256_floor_pd(x), magic)),
+          magicBits);
+    }
+
+    __m256i milli = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(q, k), half),
+        _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(q, 32), k), 32));
+    milli = _mm256_srli_epi64(milli, 32);
+    milli = _mm256_blendv_epi8(
+        milli, top,
+        _mm256_or_si256(_mm256_cmpgt_epi64(q, saturation), infinite));
+    milli = _mm256_or_si256(milli, over);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(mlux + i),
+        _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(milli, pack)));
+  }
+  tsl2591BatchScalar(lum + i, mlux + i, count - i, batch);
+}
+#endif
+
+#ifdef TSL2591_BATCH_ARM
+/**************************************************************************/
+/*!
+    @brief  Batch conversion with NEON, two readings per vector
+    @tparam Algorithm TSL2591_LUX_ALGORITHM value
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  batch Per call constants
+*/
+/**************************************************************************/
+template <uint8_t Algorithm>
+static void tsl2591BatchNeon(const uint32_t *lum, int32_t *mlux, size_t count,
+                             const tsl2591Batch_t *batch) {
+  const uint64x2_t limit = vdupq_n_u64(batch->limit);
+  const uint64x2_t saturation = vdupq_n_u64(batch->saturation);
+  const uint64x2_t top = vdupq_n_u64(0x7FFFFFFF);
+  const uint64x2_t half = vdupq_n_u64(0x80000000ULL);
+  const uint32_t k = batch->k;
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    uint64x2_t raw = vmovl_u32(vld1_u32(lum + i));
+    uint64x2_t ch0 = vandq_u64(raw, vdupq_n_u64(0xFFFF));
+    uint64x2_t ch1 = vshrq_n_u64(raw, 16);
+    uint32x2_t ch0n = vmovn_u64(ch0);
+    uint32x2_t ch1n = vmovn_u64(ch1);
+    uint64x2_t over = vorrq_u64(vcgeq_u64(ch0, limit), vcgeq_u64(ch1, limit));
+
+    uint64x2_t q, infinite = vdupq_n_u64(0);
+    if (Algorithm == TSL2591_LUX_AMS) {
+      int64x2_t n1 = vreinterpretq_s64_u64(vsubq_u64(
+          vshlq_n_u64(ch0, 16),
+          vmull_n_u32(ch1n, (uint32_t)tsl2591Q16(TSL2591_LUX_COEFB))));
+      int64x2_t n2 = vreinterpretq_s64_u64(vsubq_u64(
+          vmull_n_u32(ch0n, (uint32_t)tsl2591Q16(TSL2591_LUX_COEFC)),
+          vmull_n_u32(ch1n, (uint32_t)tsl2591Q16(TSL2591_LUX_COEFD))));
+      int64x2_t n = vbslq_s64(vcgtq_s64(n1, n2), n1, n2);
+      q = vandq_u64(vreinterpretq_u64_s64(n), vcgtq_s64(n, vdupq_n_s64(0)));
+    } else if (Algorithm == TSL2591_LUX_ALT2) {
+      int64x2_t n = vreinterpretq_s64_u64(vsubq_u64(
+          vshlq_n_u64(ch0, 16),
+          vmull_n_u32(ch1n, (uint32_t)tsl2591Q16(TSL2591_LUX_COEFE))));
+      q = vandq_u64(vreinterpretq_u64_s64(n), vcgtq_s64(n, vdupq_n_s64(0)));
+    } else {
+      uint32x2_t d = vabd_u32(ch0n, ch1n);
+      uint64x2_t d2 = vmull_u32(d, d);
+      uint64x2_t dark = vceqq_u64(ch0, vdupq_n_u64(0));
+      infinite = vbicq_u64(dark, vceqq_u64(d2, vdupq_n_u64(0)));
+      uint64x2_t divisor = vorrq_u64(ch0, vandq_u64(dark, vdupq_n_u64(1)));
+
+      float64x2_t x = vdivq_f64(vmulq_n_f64(vcvtq_f64_u64(d2), 65536.0),
+                                vcvtq_f64_u64(divisor));
+      q = vcvtq_u64_f64(vrndmq_f64(x));
+    }
+
+    uint64x2_t milli = vaddq_u64(
+        vaddq_u64(vmull_n_u32(vmovn_u64(q), k), half),
+        vshlq_n_u64(vmull_n_u32(vshrn_n_u64(q, 32), k), 32));
+    milli = vshrq_n_u64(milli, 32);
+    milli = vbslq_u64(vorrq_u64(vcgtq_u64(q, saturation), infinite), top,
+                      milli);
+    milli = vorrq_u64(milli, over);
+    vst1_s32(mlux + i, vreinterpret_s32_u32(vmovn_u64(milli)));
+  }
+  tsl2591BatchScalar(lum + i, mlux + i, count - i, batch);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Checks whether a batch path can run on this CPU
+    @param  path The path
+    @returns True if tsl2591LuxMilliBatch() can use it
+*/
+/**************************************************************************/
+bool tsl2591LuxBatchSupported(tsl2591BatchPath_t path) {
+  switch (path) {
+  case TSL2591_BATCH_SCALAR:
+  case TSL2591_BATCH_AUTO:
+    return true;
+#ifdef TSL2591_BATCH_X86
+  case TSL2591_BATCH_SSE42:
+    return __builtin_cpu_supports("sse4.2");
+  case TSL2591_BATCH_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+#ifdef TSL2591_BATCH_ARM
+  case TSL2591_BATCH_NEON:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs one path with the formula as a compile time constant
+    @tparam Algorithm TSL2591_LUX_ALGORITHM value
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  batch Per call constants
+    @param  path A supported path, not TSL2591_BATCH_AUTO
+*/
+/**************************************************************************/
+template <uint8_t Algorithm>
+static void tsl2591BatchRun(const uint32_t *lum, int32_t *mlux, size_t count,
+                            const tsl2591Batch_t *batch,
+                            tsl2591BatchPath_t path) {
+  switch (path) {
+#ifdef TSL2591_BATCH_X86
+  case TSL2591_BATCH_SSE42:
+    tsl2591BatchSse42<Algorithm>(lum, mlux, count, batch);
+    break;
+  case TSL2591_BATCH_AVX2:
+    tsl2591BatchAvx2<Algorithm>(lum, mlux, count, batch);
+    break;
+#endif
+#ifdef TSL2591_BATCH_ARM
+  case TSL2591_BATCH_NEON:
+    tsl2591BatchNeon<Algorithm>(lum, mlux, count, batch);
+    break;
+#endif
+  default:
+    tsl2591BatchScalar(lum, mlux, count, batch);
+    break;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Converts a batch of raw readings taken with the same settings,
+   e.g. a log of getFullLuminosity() words. Every result is identical to
+   Adafruit_TSL2591::calculateLuxMilli(ch0, ch1, gain, integration) when
+   uncalibrated with the same formula, whichever path runs.
+    @param  lum Raw counts, high word is IR, low word is IR+Visible
+    @param  mlux Filled with milli-lux for each reading, -1 if saturated
+    @param  count Number of readings
+    @param  control CONTROL register value the data was taken with, gain |
+   integration time (e.g. tsl2591Sample_t::control)
+    @param  calibration Scale factor, see
+   Adafruit_TSL2591::setLuxCalibration()
+    @param  algorithm Formula, one of the TSL2591_LUX_ALGORITHM values
+    @param  path Code path, TSL2591_BATCH_AUTO picks the fastest one the CPU
+   supports. An unsupported path falls back to TSL2591_BATCH_SCALAR.
+    @returns The path that ran
+*/
+/**************************************************************************/
+tsl2591BatchPath_t tsl2591LuxMilliBatch(const uint32_t *lum, int32_t *mlux,
+                                        size_t count, uint8_t control,
+                                        float calibration, uint8_t algorithm,
+                                        tsl2591BatchPath_t path) {
+  uint8_t integration = control & 0x07;
+  if (integration > 5) {
+    integration = 0; // As the driver reads unknown settings: 100ms
+  }
+
+  tsl2591Batch_t batch;
+  batch.k =
+      tsl2591Calibrate(tsl2591BatchFactor[(control >> 4) & 3][integration],
+                       tsl2591CalibrationQ16(calibration));
+  batch.limit = integration ? TSL2591_MAX_COUNT : TSL2591_MAX_COUNT_100MS;
+  batch.algorithm = algorithm;
+  // tsl2591LuxMilli() saturates results of 2^32 and up past this limit
+  batch.saturation = 0x7FFFFFFFFFFFFFFFULL;
+  if (batch.k) {
+    uint64_t saturation = ((uint64_t)0x7FFFFFFF << 32) / batch.k;
+    batch.saturation = (saturation < 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : saturation;
+  }
+
+  if (path == TSL2591_BATCH_AUTO) {
+    static const tsl2591BatchPath_t fastest[3] = {
+        TSL2591_BATCH_AVX2, TSL2591_BATCH_SSE42, TSL2591_BATCH_NEON};
+    path = TSL2591_BATCH_SCALAR;
+    for (uint8_t i = 0; i < 3; i++) {
+      if (tsl2591LuxBatchSupported(fastest[i])) {
+        path = fastest[i];
+        break;
+      }
+    }
+  } else if (!tsl2591LuxBatchSupported(path)) {
+    path = TSL2591_BATCH_SCALAR;
+  }
+
+  if (algorithm == TSL2591_LUX_AMS) {
+    tsl2591BatchRun<TSL2591_LUX_AMS>(lum, mlux, count, &batch, path);
+  } else if (algorithm == TSL2591_LUX_ALT2) {
+    tsl2591BatchRun<TSL2591_LUX_ALT2>(lum, mlux, count, &batch, path);
+  } else {
+    tsl2591BatchRun<TSL2591_LUX_ALT1>(lum, mlux, count, &batch, path);
+  }
+  return path;
+}
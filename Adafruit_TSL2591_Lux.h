@@ -0,0 +1,105 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Lux.h
+
+    Lux formula constants and batch lux conversion for the TSL2591. This
+    header has no Arduino or bus dependency, so host tools can convert logs
+    of raw getFullLuminosity() words with the same integer math as the
+    driver by building Adafruit_TSL2591_Lux.cpp alone. The batch conversion
+    uses SSE4.2, AVX2 or NEON where the CPU has them and plain C++
+    otherwise, with bit identical results on every path.
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+*/
+/**************************************************************************/
+
+#ifndef _TSL2591_LUX_H_
+#define _TSL2591_LUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TSL2591_MAX_COUNT (65535) ///< Digital count limit of a channel
+#define TSL2591_MAX_COUNT_100MS                                                \
+  (36863) ///< Analog count limit of a channel at 100ms integration
+
+#ifndef TSL2591_LUX_DF
+#define TSL2591_LUX_DF (408.0F) ///< Lux cooefficient
+#endif
+#ifndef TSL2591_LUX_COEFB
+#define TSL2591_LUX_COEFB (1.64F) ///< CH0 coefficient
+#endif
+#ifndef TSL2591_LUX_COEFC
+#define TSL2591_LUX_COEFC (0.59F) ///< CH1 coefficient A
+#endif
+#ifndef TSL2591_LUX_COEFD
+#define TSL2591_LUX_COEFD (0.86F) ///< CH2 coefficient B
+#endif
+#ifndef TSL2591_LUX_COEFE
+#define TSL2591_LUX_COEFE (1.7F) ///< CH1 coefficient, alternate calculation 2
+#endif
+
+#define TSL2591_LUX_AMS (0)  ///< Original AMS dual equation, max of the two
+#define TSL2591_LUX_ALT1 (1) ///< (ch0 - ch1) * (1 - ch1 / ch0), see issue #14
+#define TSL2591_LUX_ALT2 (2) ///< ch0 - TSL2591_LUX_COEFE * ch1
+
+#ifndef TSL2591_LUX_ALGORITHM
+#define TSL2591_LUX_ALGORITHM                                                  \
+  TSL2591_LUX_ALT1 ///< Lux formula compiled in, one of TSL2591_LUX_AMS,
+                   ///< TSL2591_LUX_ALT1 or TSL2591_LUX_ALT2
+#endif
+#if (TSL2591_LUX_ALGORITHM < 0) || (TSL2591_LUX_ALGORITHM > 2)
+#error "TSL2591_LUX_ALGORITHM must be TSL2591_LUX_AMS, _ALT1 or _ALT2"
+#endif
+#define TSL2591_LUX_INFINITE (~0ULL) ///< Formula result with no finite lux
+
+/// Code paths of tsl2591LuxMilliBatch()
+typedef enum {
+  TSL2591_BATCH_SCALAR = 0, ///< Plain C++, available everywhere
+  TSL2591_BATCH_SSE42 = 1,  ///< x86 SSE4.2, two readings per vector
+  TSL2591_BATCH_AVX2 = 2,   ///< x86 AVX2, four readings per vector
+  TSL2591_BATCH_NEON = 3,   ///< AArch64 NEON, two readings per vector
+  TSL2591_BATCH_AUTO = 0xFF ///< Fastest path the CPU supports
+} tsl2591BatchPath_t;
+
+/**************************************************************************/
+/*!
+    @brief  Milli-lux per count in Q16, 1000 * DF / (ATIME * AGAIN) * 2^16,
+   i.e. the reciprocal of CPL (counts per lux), evaluated at compile time
+    @param  control CONTROL register value, gain | integration time
+    @returns Lux factor, see Adafruit_TSL2591::luxFactor()
+*/
+/**************************************************************************/
+constexpr uint32_t tsl2591LuxFactor(uint8_t control) {
+  return (uint32_t)(1000.0F * TSL2591_LUX_DF * 65536.0F /
+                        (((control & 0x07) + 1) * 100.0F *
+                         ((control & 0x30) == 0x00   ? 1.0F
+                          : (control & 0x30) == 0x10 ? 25.0F
+                          : (control & 0x30) == 0x20 ? 428.0F
+                                                     : 9876.0F)) +
+                    0.5F);
+}
+
+/// Converts a lux coefficient to Q16 at compile time
+constexpr int64_t tsl2591Q16(float x) {
+  return (int64_t)(x * 65536.0F + 0.5F);
+}
+
+uint32_t tsl2591Calibrate(uint32_t k, uint32_t calibration);
+uint32_t tsl2591CalibrationQ16(float factor);
+
+uint64_t tsl2591LuxDual(uint32_t ch0, uint32_t ch1, uint8_t count = 1);
+uint64_t tsl2591LuxAlt1(uint32_t ch0, uint32_t ch1, uint8_t count = 1);
+uint64_t tsl2591LuxAlt2(uint32_t ch0, uint32_t ch1, uint8_t count = 1);
+int32_t tsl2591LuxMilli(uint64_t q, uint32_t k);
+float tsl2591LuxFloat(uint64_t q, uint32_t k);
+
+bool tsl2591LuxBatchSupported(tsl2591BatchPath_t path);
+tsl2591BatchPath_t tsl2591LuxMilliBatch(
+    const uint32_t *lum, int32_t *mlux, size_t count, uint8_t control,
+    float calibration = 1.0F, uint8_t algorithm = TSL2591_LUX_ALGORITHM,
+    tsl2591BatchPath_t path = TSL2591_BATCH_AUTO);
+
+#endif
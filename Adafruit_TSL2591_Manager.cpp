@@ -0,0 +1,297 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Manager.cpp
+
+    Pipelined conversions for groups of TSL2591 sensors
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2014 Adafruit Industries
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591_Manager.h"
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates an empty sensor manager
+*/
+/**************************************************************************/
+Adafruit_TSL2591_Manager::Adafruit_TSL2591_Manager(void) {
+  _count = 0;
+  _pending = 0;
+  _stale = 0;
+  _start = 0;
+  _nominal = 0;
+  _timeout = 0;
+  _muxSelect = NULL;
+  _muxContext = NULL;
+  _muxWire = NULL;
+  _muxAddr = TSL2591_TCA9548A_ADDR;
+  _muxChannel = TSL2591_NO_MUX;
+  _muxValid = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Uses a TCA9548A style mux (one control byte, bit n enables
+   channel n) to reach sensors added with a channel number
+    @param  theWire The bus the mux sits on
+    @param  addr The I2C address of the mux (Default 0x70)
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::setMux(TwoWire *theWire, uint8_t addr) {
+  _muxWire = theWire;
+  _muxAddr = addr;
+  _muxSelect = NULL;
+  _muxChannel = TSL2591_NO_MUX;
+  _muxValid = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Uses a caller supplied function to select mux channels, for
+   other mux parts or to run against simulated devices
+    @param  select Called with the channel number before a sensor on that
+   channel is accessed, or with TSL2591_NO_MUX to turn every channel off
+   before a sensor added without one
+    @param  context Passed through to select
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::setMux(tsl2591MuxSelect_t select,
+                                      void *context) {
+  _muxSelect = select;
+  _muxContext = context;
+  _muxWire = NULL;
+  _muxChannel = TSL2591_NO_MUX;
+  _muxValid = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a sensor to the group
+    @param  sensor The sensor, it should already have had begin() called
+   (with its mux channel selected)
+    @param  channel Mux channel the sensor is on (0..7), or TSL2591_NO_MUX
+   for one on the bus the mux sits on
+    @returns False if the group is full or the channel does not exist
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591_Manager::add(Adafruit_TSL2591 *sensor,
+                                      uint8_t channel) {
+  if (_count >= TSL2591_MANAGER_MAX_SENSORS) {
+    return false;
+  }
+  if ((channel > 7) && (channel != TSL2591_NO_MUX)) {
+    return false;
+  }
+
+  _sensors[_count] = sensor;
+  _channels[_count] = channel;
+  _results[_count] = 0;
+  _count++;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of sensors in the group
+    @returns Number of sensors added
+*/
+/**************************************************************************/
+uint8_t Adafruit_TSL2591_Manager::count(void) { return _count; }
+
+/**************************************************************************/
+/*!
+    @brief  Starts a conversion on every sensor without waiting
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::startAll(void) {
+  uint8_t longest = 0;
+
+  for (uint8_t i = 0; i < _count; i++) {
+    select(i);
+    _sensors[i]->startConversion();
+    _pending |= (uint32_t)1 << i;
+    if (_sensors[i]->getTiming() > longest) {
+      longest = _sensors[i]->getTiming();
+    }
+  }
+
+  _start = millis();
+  _nominal = (uint32_t)(longest + 1) * 100;
+  _timeout = (uint32_t)(longest + 1) * 120;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Harvests every sensor whose conversion has completed. Once the
+   worst case integration time has passed, the remaining sensors are read
+   regardless and flagged, see isStale().
+    @returns True when no sensor has a conversion pending
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591_Manager::poll(void) {
+  bool expired = (millis() - _start) >= _timeout;
+
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t bit = (uint32_t)1 << i;
+    if (!(_pending & bit)) {
+      continue;
+    }
+    select(i);
+    if (_sensors[i]->isReady()) {
+      harvest(i, true);
+    } else if (expired) {
+      // Whatever the channel registers hold, not this conversion
+      harvest(i, false);
+    }
+  }
+
+  return _pending == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a conversion on every sensor, waits once for the longest
+   nominal integration time and then harvests all the results
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::readAll(void) {
+  startAll();
+
+  delay(_nominal);
+  while (!poll()) {
+    delay(TSL2591_POLL_INTERVAL_MS);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the last harvested reading of one sensor
+    @param  index Sensor number, in the order they were added
+    @returns 32-bit raw count where high word is IR, low word is IR+Visible
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591_Manager::getFullLuminosity(uint8_t index) {
+  if (index >= _count) {
+    return 0;
+  }
+  return _results[index];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Converts the last harvested reading of one sensor to lux
+    @param  index Sensor number, in the order they were added
+    @returns Lux, or < 0 if overflow
+*/
+/**************************************************************************/
+float Adafruit_TSL2591_Manager::getLux(uint8_t index) {
+  if (index >= _count) {
+    return 0;
+  }
+  uint32_t x = _results[index];
+  return _sensors[index]->calculateLux(x & 0xFFFF, x >> 16);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Tells whether the last harvested reading of one sensor is
+   stale: the conversion had not completed by the worst case integration
+   time, so the reading is what the sensor held from an earlier conversion
+   (or 0), or the read failed and the previous reading was kept. Check it
+   after poll() or readAll() before trusting the value.
+    @param  index Sensor number, in the order they were added
+    @returns True if the reading did not come from the last conversion
+*/
+/**************************************************************************/
+boolean Adafruit_TSL2591_Manager::isStale(uint8_t index) {
+  if (index >= _count) {
+    return true;
+  }
+  return (_stale >> index) & 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Routes the bus to the mux channel of a sensor, skipping the mux
+   write if that channel is already selected. A sensor added without a
+   channel sits on the same bus as the mux, so every channel is turned off
+   first in case one holds a sensor at the same address. The channel is
+   only remembered once the mux acknowledged it.
+    @param  index Sensor number
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::select(uint8_t index) {
+  uint8_t channel = _channels[index];
+  if (_muxValid && (channel == _muxChannel)) {
+    return;
+  }
+
+  bool ok = true;
+  if (_muxSelect) {
+    _muxSelect(channel, _muxContext);
+  } else if (_muxWire) {
+    _muxWire->beginTransmission(_muxAddr);
+    _muxWire->write((channel == TSL2591_NO_MUX) ? 0 : 1 << channel);
+    ok = _muxWire->endTransmission() == 0;
+  } else {
+    return;
+  }
+  _muxChannel = channel;
+  _muxValid = ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the result of one sensor and marks it done. If the read
+   fails the previous reading is kept and flagged stale.
+    @param  index Sensor number, its mux channel must be selected
+    @param  ready True if the sensor reported the conversion complete
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_Manager::harvest(uint8_t index, bool ready) {
+  uint32_t bit = (uint32_t)1 << index;
+  uint32_t x;
+  if (_sensors[index]->readResult(&x) == TSL2591_OK) {
+    _results[index] = x;
+  } else {
+    ready = false;
+  }
+  if (ready) {
+    _stale &= ~bit;
+  } else {
+    _stale |= bit;
+  }
+  _pending &= ~bit;
+}
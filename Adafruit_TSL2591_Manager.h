@@ -0,0 +1,109 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Manager.h
+
+    Drives several TSL2591 sensors together, either on separate buses or
+    behind an I2C multiplexer such as the TCA9548A (all TSL2591s share the
+    fixed address 0x29). Conversions are started on every sensor, the
+    manager waits once for the longest integration time and then harvests
+    all results, so N sensors cost about one integration period instead of N.
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2014 Adafruit Industries
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _TSL2591_MANAGER_H_
+#define _TSL2591_MANAGER_H_
+
+#include "Adafruit_TSL2591.h"
+
+#ifndef TSL2591_MANAGER_MAX_SENSORS
+#define TSL2591_MANAGER_MAX_SENSORS (8) ///< Sensors a manager can hold
+#endif
+#if TSL2591_MANAGER_MAX_SENSORS > 32
+#error "TSL2591_MANAGER_MAX_SENSORS is limited to 32"
+#endif
+
+#define TSL2591_TCA9548A_ADDR (0x70) ///< Default TCA9548A I2C address
+#define TSL2591_NO_MUX (0xFF)        ///< Sensor is not behind a mux channel
+
+/// Callback that routes the bus to a mux channel before a sensor is accessed,
+/// or turns every channel off (TSL2591_NO_MUX) for a sensor on the main bus
+typedef void (*tsl2591MuxSelect_t)(uint8_t channel, void *context);
+
+/**************************************************************************/
+/*!
+    @brief  Class that starts, waits for and harvests conversions on a group
+   of TSL2591 sensors
+*/
+/**************************************************************************/
+class Adafruit_TSL2591_Manager {
+public:
+  Adafruit_TSL2591_Manager(void);
+
+  void setMux(TwoWire *theWire, uint8_t addr = TSL2591_TCA9548A_ADDR);
+  void setMux(tsl2591MuxSelect_t select, void *context = NULL);
+  boolean add(Adafruit_TSL2591 *sensor, uint8_t channel = TSL2591_NO_MUX);
+  uint8_t count(void);
+
+  void startAll(void);
+  boolean poll(void);
+  void readAll(void);
+  uint32_t getFullLuminosity(uint8_t index);
+  float getLux(uint8_t index);
+  boolean isStale(uint8_t index);
+
+private:
+  void select(uint8_t index);
+  void harvest(uint8_t index, bool ready);
+
+  Adafruit_TSL2591 *_sensors[TSL2591_MANAGER_MAX_SENSORS];
+  uint8_t _channels[TSL2591_MANAGER_MAX_SENSORS];
+  uint32_t _results[TSL2591_MANAGER_MAX_SENSORS];
+  uint8_t _count;
+  uint32_t _pending; ///< Bit n set while sensor n has a conversion running
+  uint32_t _stale;   ///< Bit n set if sensor n's reading is not fresh
+  uint32_t _start;
+  uint32_t _nominal; ///< Longest nominal integration time in the group
+  uint32_t _timeout; ///< Worst case integration time in the group
+
+  tsl2591MuxSelect_t _muxSelect;
+  void *_muxContext;
+  TwoWire *_muxWire;
+  uint8_t _muxAddr;
+  uint8_t _muxChannel;
+  bool _muxValid; ///< The mux is known to have _muxChannel selected
+};
+
+#endif
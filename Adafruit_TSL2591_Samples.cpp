@@ -0,0 +1,325 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Samples.cpp
+
+    Fixed capacity sample storage for the TSL2591 driver
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2014 Adafruit Industries
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591_Samples.h"
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates a sample buffer on caller provided storage
+    @param  storage Array of at least capacity samples
+    @param  capacity Number of samples kept before the oldest is overwritten
+*/
+/**************************************************************************/
+Adafruit_TSL2591_SampleBuffer::Adafruit_TSL2591_SampleBuffer(
+    tsl2591Sample_t *storage, uint16_t capacity) {
+  _storage = storage;
+  _capacity = capacity;
+  _emaShift = TSL2591_EMA_SHIFT;
+  clear();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stores a sample, overwriting the oldest one when full, and
+   adds it to the statistics in constant time
+    @param  sample The raw sample
+    @param  milliLux Lux for the sample in milli-lux, or < 0 on overflow
+   (overflowed samples are stored but left out of the lux statistics)
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_SampleBuffer::push(const tsl2591Sample_t *sample,
+                                         int32_t milliLux) {
+  if (_size < _capacity) {
+    _size++;
+  }
+  _storage[_head] = *sample;
+  _head = (_head + 1 == _capacity) ? 0 : _head + 1;
+
+  if (milliLux < 0) {
+    _overflows++;
+    return;
+  }
+
+  if (_count == 0) {
+    _min = _max = milliLux;
+  } else {
+    if (milliLux < _min) {
+      _min = milliLux;
+    }
+    if (milliLux > _max) {
+      _max = milliLux;
+    }
+  }
+  _count++;
+  _sum += milliLux;
+
+  // The EMA is kept scaled by 2^shift, so the fraction an integer step
+  // would drop carries over and the average reaches a steady input
+  if (_ema < 0) {
+    _ema = (int64_t)milliLux << _emaShift;
+  } else {
+    _ema += milliLux - (_ema >> _emaShift);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets a stored sample
+    @param  age 0 for the newest sample, 1 for the one before, ...
+    @param  sample Pointer to a tsl2591Sample_t that will be filled in
+    @returns False if there are not that many samples stored
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591_SampleBuffer::get(uint16_t age,
+                                        tsl2591Sample_t *sample) {
+  if (age >= _size) {
+    return false;
+  }
+
+  uint16_t index = (_head >= age + 1) ? _head - age - 1
+                                      : _head + _capacity - age - 1;
+  *sample = _storage[index];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drops all samples and resets the statistics
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_SampleBuffer::clear(void) {
+  _head = 0;
+  _size = 0;
+  _count = 0;
+  _overflows = 0;
+  _min = 0;
+  _max = 0;
+  _sum = 0;
+  _ema = -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples currently stored
+    @returns Stored samples, at most capacity()
+*/
+/**************************************************************************/
+uint16_t Adafruit_TSL2591_SampleBuffer::size(void) { return _size; }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples the buffer can hold
+    @returns Capacity in samples
+*/
+/**************************************************************************/
+uint16_t Adafruit_TSL2591_SampleBuffer::capacity(void) { return _capacity; }
+
+/**************************************************************************/
+/*!
+    @brief  Sets how quickly the exponential moving average follows new
+   samples
+    @param  shift Each sample moves the average by 1/2^shift of the
+   difference (0 follows the last sample exactly), at most 24
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_SampleBuffer::setEmaShift(uint8_t shift) {
+  if (shift > 24) {
+    shift = 24;
+  }
+  if (_ema >= 0) {
+    // Keep the current average, at the new scale
+    _ema = (_ema >> _emaShift) << shift;
+  }
+  _emaShift = shift;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples with a valid lux value
+    @returns Non overflowed samples pushed since clear()
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591_SampleBuffer::count(void) { return _count; }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples that overflowed
+    @returns Samples pushed since clear() that had no valid lux value
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591_SampleBuffer::overflows(void) { return _overflows; }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the lowest lux since clear()
+    @returns Milli-lux, 0 if no samples
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591_SampleBuffer::minLux(void) { return _min; }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the highest lux since clear()
+    @returns Milli-lux, 0 if no samples
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591_SampleBuffer::maxLux(void) { return _max; }
+
+/**************************************************************************/
+/*!
+    @brief  Gets the mean lux since clear()
+    @returns Milli-lux, 0 if no samples
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591_SampleBuffer::meanLux(void) {
+  if (_count == 0) {
+    return 0;
+  }
+  // Below 65536 samples the sum has at most 47 bits, so two 32 bit
+  // divisions do it without a 64 bit division
+  if (_count <= 0xFFFF) {
+    uint32_t high = _sum >> 16;
+    uint32_t low = ((high % _count) << 16) | (uint16_t)_sum;
+    return ((high / _count) << 16) | (low / _count);
+  }
+  return (int32_t)(_sum / _count);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the exponential moving average of lux since clear()
+    @returns Milli-lux, 0 if no samples
+*/
+/**************************************************************************/
+int32_t Adafruit_TSL2591_SampleBuffer::emaLux(void) {
+  return (_ema < 0) ? 0 : (int32_t)(_ema >> _emaShift);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates a sample queue on caller provided storage
+    @param  storage Array of at least capacity + 1 samples
+    @param  capacity Number of samples that can be queued, at most 254
+*/
+/**************************************************************************/
+Adafruit_TSL2591_SampleQueue::Adafruit_TSL2591_SampleQueue(
+    tsl2591Sample_t *storage, uint8_t capacity) {
+  _storage = storage;
+  _slots = capacity + 1;
+  _head = 0;
+  _tail = 0;
+  _dropped = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a sample, producer side only
+    @param  sample The sample to queue
+    @returns False if the queue was full and the sample was dropped
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591_SampleQueue::push(const tsl2591Sample_t *sample) {
+  uint8_t head = _head;
+  uint8_t next = (head + 1 == _slots) ? 0 : head + 1;
+  if (next == _tail) {
+    _dropped = _dropped + 1;
+    return false;
+  }
+
+  _storage[head] = *sample;
+  // Publish the slot only once its contents are written
+  TSL2591_BARRIER();
+  _head = next;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Counts samples the producer lost before they reached the queue,
+   producer side only
+    @param  count Samples lost
+*/
+/**************************************************************************/
+void Adafruit_TSL2591_SampleQueue::drop(uint32_t count) {
+  _dropped = _dropped + count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Removes the oldest sample, consumer side only
+    @param  sample Pointer to a tsl2591Sample_t that will be filled in
+    @returns False if the queue was empty
+*/
+/**************************************************************************/
+bool Adafruit_TSL2591_SampleQueue::pop(tsl2591Sample_t *sample) {
+  uint8_t tail = _tail;
+  if (tail == _head) {
+    return false;
+  }
+
+  TSL2591_BARRIER();
+  *sample = _storage[tail];
+  // Hand the slot back only once it has been copied out
+  TSL2591_BARRIER();
+  _tail = (tail + 1 == _slots) ? 0 : tail + 1;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of queued samples
+    @returns Samples waiting to be popped
+*/
+/**************************************************************************/
+uint8_t Adafruit_TSL2591_SampleQueue::available(void) {
+  uint8_t head = _head;
+  uint8_t tail = _tail;
+  return (head >= tail) ? head - tail : head + _slots - tail;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the number of samples dropped, because the queue was full
+   or because the producer missed them (see drop())
+    @returns Dropped samples since construction
+*/
+/**************************************************************************/
+uint32_t Adafruit_TSL2591_SampleQueue::dropped(void) { return _dropped; }
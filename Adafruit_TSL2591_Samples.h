@@ -0,0 +1,176 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_TSL2591_Samples.h
+
+    Fixed capacity sample storage for the TSL2591 driver. Samples are kept
+    as raw channel counts plus the CONTROL value they were taken with, with
+    no heap use. The ring buffer keeps a history with lux statistics
+    updated in constant time per sample, the queue hands samples from an
+    interrupt (or task) to the main loop without locking.
+
+    Adafruit invests time and resources providing this open source code,
+    please support Adafruit and open-source hardware by purchasing
+    products from Adafruit!
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2014 Adafruit Industries
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _TSL2591_SAMPLES_H_
+#define _TSL2591_SAMPLES_H_
+
+#include <Arduino.h>
+
+#define TSL2591_EMA_SHIFT                                                      \
+  (3) ///< Default EMA smoothing, each sample moves the average by 1/2^shift
+
+#if defined(__AVR__)
+#define TSL2591_BARRIER()                                                      \
+  __asm__ __volatile__("" ::: "memory") ///< Compiler barrier (single core)
+#else
+#define TSL2591_BARRIER() __sync_synchronize() ///< Full memory barrier
+#endif
+
+/// One raw reading plus the settings it was taken with
+typedef struct {
+  uint32_t timestamp; ///< millis() when the data was read
+  uint16_t ch0;       ///< Channel 0 (IR+Visible) counts
+  uint16_t ch1;       ///< Channel 1 (IR) counts
+  uint8_t control;    ///< CONTROL register value, gain | integration
+} tsl2591Sample_t;
+
+/**************************************************************************/
+/*!
+    @brief  Ring buffer of raw samples with streaming lux statistics. The
+   statistics cover every sample pushed since clear(), not only the ones
+   still stored, so each push updates them in constant time and no lux is
+   kept per sample. Use Adafruit_TSL2591_SampleRing to get one with built-in
+   storage.
+*/
+/**************************************************************************/
+class Adafruit_TSL2591_SampleBuffer {
+public:
+  Adafruit_TSL2591_SampleBuffer(tsl2591Sample_t *storage, uint16_t capacity);
+
+  void push(const tsl2591Sample_t *sample, int32_t milliLux);
+  bool get(uint16_t age, tsl2591Sample_t *sample);
+  void clear(void);
+  uint16_t size(void);
+  uint16_t capacity(void);
+
+  void setEmaShift(uint8_t shift);
+  uint32_t count(void);
+  uint32_t overflows(void);
+  int32_t minLux(void);
+  int32_t maxLux(void);
+  int32_t meanLux(void);
+  int32_t emaLux(void);
+
+private:
+  tsl2591Sample_t *_storage;
+  uint16_t _capacity;
+  uint16_t _head; ///< Slot the next sample goes into
+  uint16_t _size;
+
+  uint8_t _emaShift;
+  uint32_t _count;     ///< Samples with a valid lux value since clear()
+  uint32_t _overflows; ///< Samples without one since clear()
+  int32_t _min;
+  int32_t _max;
+  uint64_t _sum; ///< Exact, see meanLux()
+  int64_t _ema;  ///< EMA scaled by 2^_emaShift, so it settles exactly
+};
+
+/**************************************************************************/
+/*!
+    @brief  Sample ring buffer holding its own storage for N samples
+    @tparam N Number of samples kept
+*/
+/**************************************************************************/
+template <uint16_t N>
+class Adafruit_TSL2591_SampleRing : public Adafruit_TSL2591_SampleBuffer {
+public:
+  /*!
+      @brief  Instantiates an empty ring of N samples
+  */
+  Adafruit_TSL2591_SampleRing()
+      : Adafruit_TSL2591_SampleBuffer(_samples, N) {}
+
+private:
+  tsl2591Sample_t _samples[N];
+};
+
+/**************************************************************************/
+/*!
+    @brief  Lock-free single producer, single consumer queue of raw samples.
+   One side (typically an interrupt handler or task) calls push(), the other
+   (the main loop) calls pop(); neither disables interrupts. Use
+   Adafruit_TSL2591_SampleFifo to get one with built-in storage.
+*/
+/**************************************************************************/
+class Adafruit_TSL2591_SampleQueue {
+public:
+  Adafruit_TSL2591_SampleQueue(tsl2591Sample_t *storage, uint8_t capacity);
+
+  bool push(const tsl2591Sample_t *sample);
+  void drop(uint32_t count);
+  bool pop(tsl2591Sample_t *sample);
+  uint8_t available(void);
+  uint32_t dropped(void);
+
+private:
+  tsl2591Sample_t *_storage;
+  uint8_t _slots;             ///< capacity + 1, one slot is always kept free
+  volatile uint8_t _head;     ///< Next slot to write, only moved by push()
+  volatile uint8_t _tail;     ///< Next slot to read, only moved by pop()
+  volatile uint32_t _dropped; ///< Samples lost, see dropped()
+};
+
+/**************************************************************************/
+/*!
+    @brief  Sample queue holding its own storage for N samples
+    @tparam N Number of samples that can be queued, at most 254
+*/
+/**************************************************************************/
+template <uint8_t N>
+class Adafruit_TSL2591_SampleFifo : public Adafruit_TSL2591_SampleQueue {
+  static_assert(N < 255, "Adafruit_TSL2591_SampleFifo holds at most 254");
+
+public:
+  /*!
+      @brief  Instantiates an empty queue of N samples
+  */
+  Adafruit_TSL2591_SampleFifo() : Adafruit_TSL2591_SampleQueue(_samples, N) {}
+
+private:
+  tsl2591Sample_t _samples[N + 1];
+};
+
+#endif
@@ -0,0 +1,200 @@
+/* TSL2591 Digital Light Sensor, API cost benchmark */
+
+/*  Measures what each driver call costs: I2C transactions, bytes on the
+ *  wire (including address bytes), time spent on the bus and total wall
+ *  time. The difference between wall and bus time is spent waiting for
+ *  conversions or computing. When built with TSL2591_ENABLE_STATS set (a
+ *  build flag for the library and this sketch alike, setting it for only
+ *  one of them fails to link), the time spent in delay() is reported too,
+ *  and what is left is the CPU time of the call (the wait_us and cpu_us
+ *  columns are left empty otherwise).
+ *
+ *  Results are printed as CSV so they can be collected and compared
+ *  across releases:
+ *
+ *    call,iterations,transactions,bytes,wall_us,bus_us,other_us,wait_us,cpu_us
+ *
+ *  All columns after iterations are per call averages.
+ *
+ *  extras/host builds this sketch for a desktop against a simulated sensor
+ *  (tsl2591_benchmark target), with more iterations and a clock that adds
+ *  real CPU time to the simulated bus and conversion time.
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+#include "Adafruit_TSL2591_Fixed.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+
+#ifndef ITERATIONS
+#define ITERATIONS (4)
+#endif
+// Clock the calls are timed with, in microseconds
+#ifndef BENCH_MICROS
+#define BENCH_MICROS() micros()
+#endif
+#define BATCH (32)
+
+Adafruit_TSL2591 tsl = Adafruit_TSL2591(2591); // pass in a number for the sensor identifier (for your use later)
+
+// Same settings with each lux formula, for comparing their cost
+typedef Adafruit_TSL2591_Fixed<TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS, TSL2591_LUX_AMS> LuxAms;
+typedef Adafruit_TSL2591_Fixed<TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS, TSL2591_LUX_ALT1> LuxAlt1;
+typedef Adafruit_TSL2591_Fixed<TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS, TSL2591_LUX_ALT2> LuxAlt2;
+
+uint32_t raw[BATCH];
+int32_t mlux[BATCH];
+
+uint32_t transactions = 0;
+uint32_t bytes = 0;
+uint32_t busTime = 0;
+
+/**************************************************************************/
+/*
+    Bus monitor, tallies every transaction the driver issues
+*/
+/**************************************************************************/
+void countTransaction(const tsl2591Transaction_t *t, void *context)
+{
+  (void)context;
+  transactions++;
+  // address + command + payload, reads need a second address byte. The
+  // address probe in begin() is the address alone
+  if (t->command == TSL2591_ADDRESS_PROBE)
+  {
+    bytes += 1;
+  }
+  else
+  {
+    bytes += 2 + t->written + t->read + (t->read ? 1 : 0);
+  }
+  busTime += t->duration;
+}
+
+/**************************************************************************/
+/*
+    Prints one CSV result row
+*/
+/**************************************************************************/
+void report(const __FlashStringHelper *name, uint32_t wall)
+{
+  Serial.print(name); Serial.print(',');
+  Serial.print(ITERATIONS); Serial.print(',');
+  Serial.print((float)transactions / ITERATIONS, 2); Serial.print(',');
+  Serial.print((float)bytes / ITERATIONS, 2); Serial.print(',');
+  Serial.print((float)wall / ITERATIONS, 2); Serial.print(',');
+  Serial.print((float)busTime / ITERATIONS, 2); Serial.print(',');
+  Serial.print((float)(wall - busTime) / ITERATIONS, 2); Serial.print(',');
+#if TSL2591_ENABLE_STATS
+  tsl2591Stats_t stats;
+  tsl.getStats(&stats);
+  uint32_t wait = stats.waitMs * 1000;
+  Serial.print((float)wait / ITERATIONS, 2); Serial.print(',');
+  // Clock granularity can put the wait above the rest, report 0 then
+  uint32_t other = wall - busTime;
+  Serial.print((float)(other > wait ? other - wait : 0) / ITERATIONS, 2);
+#else
+  Serial.print(',');
+#endif
+  Serial.println();
+}
+
+#if TSL2591_ENABLE_STATS
+#define RESET_STATS() tsl.resetStats()
+#else
+#define RESET_STATS()
+#endif
+
+// Runs a statement ITERATIONS times and reports its average cost
+#define BENCH(name, statement)                        \
+  do {                                                \
+    transactions = bytes = busTime = 0;               \
+    RESET_STATS();                                    \
+    uint32_t start = BENCH_MICROS();                  \
+    for (uint16_t i = 0; i < ITERATIONS; i++) {       \
+      statement;                                      \
+    }                                                 \
+    report(F(name), BENCH_MICROS() - start);          \
+  } while (0)
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(115200);
+
+  // Enable this line for Flora, Zero and Feather boards with no FTDI chip
+  // Waits for the serial port to connect before sending data out
+  // while (!Serial) { delay(1); }
+
+  tsl.setBusMonitor(countTransaction);
+  if (!tsl.begin())
+  {
+    Serial.println(F("No sensor found ... check your wiring?"));
+    while (1);
+  }
+
+  sensors_event_t event;
+  tsl2591Config_t config;
+  config.gain = TSL2591_GAIN_MED;
+  config.integration = TSL2591_INTEGRATIONTIME_100MS;
+  config.persist = TSL2591_PERSIST_ANY;
+  config.lowerThreshold = 100;
+  config.upperThreshold = 1500;
+  config.npLowerThreshold = 0;
+  config.npUpperThreshold = 0xFFFF;
+  config.power = TSL2591_POWER_OFF;
+
+  Serial.println(F("call,iterations,transactions,bytes,wall_us,bus_us,other_us,wait_us,cpu_us"));
+  BENCH("begin", tsl.begin());
+  BENCH("begin(config)", tsl.begin(&config));
+  tsl2591State_t state;
+  tsl.exportState(&state);
+  BENCH("resume", tsl.resume(&state));
+  tsl.disable();
+  BENCH("setGain(same)", tsl.setGain(TSL2591_GAIN_MED));
+  BENCH("setGain(change)", tsl.setGain(i & 1 ? TSL2591_GAIN_LOW : TSL2591_GAIN_MED));
+  BENCH("setTiming(same)", tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS));
+  BENCH("setTiming(change)", tsl.setTiming(i & 1 ? TSL2591_INTEGRATIONTIME_200MS : TSL2591_INTEGRATIONTIME_100MS));
+  BENCH("getFullLuminosity", tsl.getFullLuminosity());
+  BENCH("getEvent", tsl.getEvent(&event));
+  BENCH("registerInterrupt", tsl.registerInterrupt(100 + i, 1500, TSL2591_PERSIST_ANY));
+  BENCH("clearInterrupt", tsl.clearInterrupt());
+  BENCH("getStatus", tsl.getStatus());
+  BENCH("verifyState", tsl.verifyState());
+  BENCH("calculateLux", tsl.calculateLux(1000 + i, 200));
+
+  // Lux throughput over a log of raw words, one call per sample against one
+  // batch call (per call columns cover all BATCH samples)
+  for (uint8_t n = 0; n < BATCH; n++)
+  {
+    raw[n] = (uint32_t)(200 + n) << 16 | (1000 + 37 * n);
+  }
+  BENCH("calculateLuxMilli(x32)", for (uint8_t n = 0; n < BATCH; n++) mlux[n] = Adafruit_TSL2591::calculateLuxMilli(raw[n] & 0xFFFF, raw[n] >> 16, TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS));
+  BENCH("calculateLuxMilli(batch32)", Adafruit_TSL2591::calculateLuxMilli(raw, mlux, BATCH, TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS));
+
+  // Lux formulas side by side, fixed settings so only the formula differs
+  BENCH("luxAms(x32)", for (uint8_t n = 0; n < BATCH; n++) mlux[n] = LuxAms::calculateLuxMilli(raw[n] & 0xFFFF, raw[n] >> 16));
+  BENCH("luxAlt1(x32)", for (uint8_t n = 0; n < BATCH; n++) mlux[n] = LuxAlt1::calculateLuxMilli(raw[n] & 0xFFFF, raw[n] >> 16));
+  BENCH("luxAlt2(x32)", for (uint8_t n = 0; n < BATCH; n++) mlux[n] = LuxAlt2::calculateLuxMilli(raw[n] & 0xFFFF, raw[n] >> 16));
+  Serial.println(F("done"));
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, nothing to do once the benchmark has run
+*/
+/**************************************************************************/
+void loop(void)
+{
+}
@@ -0,0 +1,92 @@
+/* TSL2591 Digital Light Sensor, interrupt driven sampling */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  The sensor runs continuously with the persist filter set to
+ *  TSL2591_PERSIST_EVERY, so the INT pin goes low after every completed
+ *  conversion. The pin ISR only notes the event; serviceInterrupt()
+ *  then fetches the data and clears the interrupt (two bus transactions,
+ *  no status polling) and pushes the sample into a lock-free queue that
+ *  loop() drains. Between conversions the sketch has nothing to do.
+ *
+ *  serviceInterrupt() uses the I2C driver, so call it from loop() or from
+ *  an RTOS task woken by the pin, never from the ISR itself. Conversions
+ *  that were overwritten because it ran late show up in dropped().
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+// connect INT to INTERRUPT_PIN (open drain, active low)
+
+#define INTERRUPT_PIN (2)
+
+Adafruit_TSL2591 tsl = Adafruit_TSL2591(2591); // pass in a number for the sensor identifier (for your use later)
+Adafruit_TSL2591_SampleFifo<8> samples;
+
+/**************************************************************************/
+/*
+    INT pin handler
+*/
+/**************************************************************************/
+void sensorInterrupt(void)
+{
+  tsl.handleInterrupt();
+}
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  Serial.println(F("Starting Adafruit TSL2591 data ready Test!"));
+
+  if (tsl.begin())
+  {
+    Serial.println(F("Found a TSL2591 sensor"));
+  }
+  else
+  {
+    Serial.println(F("No sensor found ... check your wiring?"));
+    while (1);
+  }
+
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_200MS);
+
+  pinMode(INTERRUPT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(INTERRUPT_PIN), sensorInterrupt, FALLING);
+
+  tsl.startDataReadyInterrupt(&samples);
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, called once 'setup' is complete (your own code
+    should go here)
+*/
+/**************************************************************************/
+void loop(void)
+{
+  tsl.serviceInterrupt();
+
+  tsl2591Sample_t sample;
+  while (samples.pop(&sample))
+  {
+    Serial.print(F("[ ")); Serial.print(sample.timestamp); Serial.print(F(" ms ] "));
+    Serial.print(F("IR: ")); Serial.print(sample.ch1); Serial.print(F("  "));
+    Serial.print(F("Full: ")); Serial.print(sample.ch0); Serial.print(F("  "));
+    Serial.print(F("Lux: ")); Serial.println(tsl.calculateLux(sample.ch0, sample.ch1), 6);
+  }
+}
@@ -0,0 +1,122 @@
+/* TSL2591 Digital Light Sensor, deep sleep example */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  For battery nodes that deep sleep between readings while the sensor
+ *  stays powered. The driver state is saved in memory that survives the
+ *  sleep, and on wake resume() loads it and starts a conversion with a
+ *  single write, instead of begin() identifying and setting up the chip
+ *  again. The first reading also checks that the sensor kept its settings.
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+
+#define SLEEP_MS (10000)
+
+#if defined(ESP32)
+#define RETAINED RTC_DATA_ATTR
+#else
+// Place these in memory that survives your board's sleep mode
+#define RETAINED
+#endif
+
+RETAINED tsl2591State_t state;
+RETAINED bool haveState = false;
+
+Adafruit_TSL2591 tsl = Adafruit_TSL2591(2591); // pass in a number for the sensor identifier (for your use later)
+
+/**************************************************************************/
+/*
+    Sleeps until the next reading is due
+*/
+/**************************************************************************/
+void sleepFor(uint32_t ms)
+{
+#if defined(ESP32)
+  esp_sleep_enable_timer_wakeup(ms * 1000ULL);
+  esp_deep_sleep_start();
+#else
+  // Replace with your board's deep sleep
+  delay(ms);
+#endif
+}
+
+/**************************************************************************/
+/*
+    Takes one reading, right after waking up
+*/
+/**************************************************************************/
+void wake(void)
+{
+  if (!haveState || !tsl.resume(&state))
+  {
+    // First boot, or the saved state was lost: set the sensor up in full
+    tsl2591Config_t config;
+    config.gain = TSL2591_GAIN_MED;
+    config.integration = TSL2591_INTEGRATIONTIME_100MS;
+    config.persist = TSL2591_PERSIST_ANY;
+    config.lowerThreshold = 0;
+    config.upperThreshold = 0xFFFF;
+    config.npLowerThreshold = 0;
+    config.npUpperThreshold = 0xFFFF;
+    config.power = TSL2591_POWER_OFF;
+    if (!tsl.begin(&config))
+    {
+      Serial.println(F("No sensor found ... check your wiring?"));
+      sleepFor(SLEEP_MS);
+      return;
+    }
+  }
+
+  float lux;
+  tsl2591Result_t result = tsl.readLux(&lux);
+  Serial.print(F("[ ")); Serial.print(millis()); Serial.print(F(" ms ] "));
+  if (result == TSL2591_OK)
+  {
+    Serial.print(F("Lux: ")); Serial.println(lux, 3);
+  }
+  else if (result == TSL2591_ERR_RESET)
+  {
+    // The reading used the chip's power on defaults, it has been set up again
+    Serial.println(F("Sensor was reset while sleeping, settings restored"));
+  }
+  else
+  {
+    Serial.print(F("Read failed, error ")); Serial.println(result);
+  }
+
+  haveState = tsl.exportState(&state);
+  sleepFor(SLEEP_MS);
+}
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch, runs on every wake up when
+    the board resets out of deep sleep
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  wake();
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, only reached on boards where sleepFor() returns
+*/
+/**************************************************************************/
+void loop(void)
+{
+  wake();
+}
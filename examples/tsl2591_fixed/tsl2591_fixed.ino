@@ -0,0 +1,66 @@
+/* TSL2591 Digital Light Sensor, fixed settings example */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  For sketches that never change gain or integration time. Both are
+ *  template parameters of Adafruit_TSL2591_Fixed, so invalid settings
+ *  fail to compile and the lux factor is worked out by the compiler.
+ *  The driver holds no settings and never touches the heap, which keeps
+ *  it small on the tiniest boards.
+ */
+
+#include <Wire.h>
+#include "Adafruit_TSL2591_Fixed.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+
+Adafruit_TSL2591_Fixed<TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_300MS> tsl;
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  Serial.println(F("Starting Adafruit TSL2591 fixed settings Test!"));
+
+  if (tsl.begin())
+  {
+    Serial.println(F("Found a TSL2591 sensor"));
+  }
+  else
+  {
+    Serial.println(F("No sensor found ... check your wiring?"));
+    while (1);
+  }
+
+  Serial.print(F("Conversion time: ")); Serial.print(tsl.conversionMs); Serial.println(F(" ms"));
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, called once 'setup' is complete (your own code
+    should go here)
+*/
+/**************************************************************************/
+void loop(void)
+{
+  uint32_t lum = tsl.getFullLuminosity();
+  uint16_t ir, full;
+  ir = lum >> 16;
+  full = lum & 0xFFFF;
+  Serial.print(F("[ ")); Serial.print(millis()); Serial.print(F(" ms ] "));
+  Serial.print(F("IR: ")); Serial.print(ir); Serial.print(F("  "));
+  Serial.print(F("Full: ")); Serial.print(full); Serial.print(F("  "));
+  Serial.print(F("Lux: ")); Serial.println(tsl.calculateLux(full, ir), 6);
+
+  delay(500);
+}
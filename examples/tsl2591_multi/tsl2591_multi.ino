@@ -0,0 +1,96 @@
+/* TSL2591 Digital Light Sensor, several sensors behind a TCA9548A mux */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  Every TSL2591 uses the same I2C address (0x29), so more than one
+ *  sensor needs an I2C multiplexer such as the TCA9548A. Reading them
+ *  one after the other costs one integration time per sensor.
+ *  Adafruit_TSL2591_Manager starts a conversion on all of them, waits
+ *  once and then collects every result, so the whole group costs about
+ *  one integration time.
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+#include "Adafruit_TSL2591_Manager.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect the TCA9548A to SCL/SDA, and one TSL2591 to each of
+// mux channels 0..NUM_SENSORS-1
+
+#define NUM_SENSORS (3)
+
+Adafruit_TSL2591 tsl[NUM_SENSORS];
+Adafruit_TSL2591_Manager manager;
+
+/**************************************************************************/
+/*
+    Routes the bus to one mux channel, only needed during setup since
+    the manager takes care of it afterwards
+*/
+/**************************************************************************/
+void selectChannel(uint8_t channel)
+{
+  Wire.beginTransmission(TSL2591_TCA9548A_ADDR);
+  Wire.write(1 << channel);
+  Wire.endTransmission();
+}
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  Serial.println(F("Starting Adafruit TSL2591 multi sensor Test!"));
+
+  Wire.begin();
+  manager.setMux(&Wire);
+
+  for (uint8_t i = 0; i < NUM_SENSORS; i++)
+  {
+    selectChannel(i);
+    if (!tsl[i].begin())
+    {
+      Serial.print(F("No sensor found on channel ")); Serial.println(i);
+      while (1);
+    }
+    tsl[i].setGain(TSL2591_GAIN_MED);
+    tsl[i].setTiming(TSL2591_INTEGRATIONTIME_100MS);
+    manager.add(&tsl[i], i);
+  }
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, called once 'setup' is complete (your own code
+    should go here)
+*/
+/**************************************************************************/
+void loop(void)
+{
+  uint32_t start = millis();
+  manager.readAll();
+  uint32_t took = millis() - start;
+
+  Serial.print(F("[ ")); Serial.print(took); Serial.print(F(" ms ] "));
+  for (uint8_t i = 0; i < manager.count(); i++)
+  {
+    Serial.print(F("Lux ")); Serial.print(i); Serial.print(F(": "));
+    Serial.print(manager.getLux(i), 3);
+    if (manager.isStale(i))
+    {
+      // The conversion did not finish in time, this is an older reading
+      Serial.print(F(" (stale)"));
+    }
+    Serial.print(F("  "));
+  }
+  Serial.println();
+
+  delay(500);
+}
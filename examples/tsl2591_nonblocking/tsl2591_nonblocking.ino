@@ -0,0 +1,82 @@
+/* TSL2591 Digital Light Sensor, non-blocking example */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  This example shows how to take readings without stalling the sketch
+ *  for the whole integration time. startConversion() powers up the ADC
+ *  and returns right away, isReady() checks the AVALID bit in the status
+ *  register and readResult() fetches both channels and powers back down.
+ *  The rest of loop() keeps running while the sensor integrates.
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+
+Adafruit_TSL2591 tsl = Adafruit_TSL2591(2591); // pass in a number for the sensor identifier (for your use later)
+
+uint32_t loops = 0;
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  Serial.println(F("Starting Adafruit TSL2591 non-blocking Test!"));
+
+  if (tsl.begin())
+  {
+    Serial.println(F("Found a TSL2591 sensor"));
+  }
+  else
+  {
+    Serial.println(F("No sensor found ... check your wiring?"));
+    while (1);
+  }
+
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_300MS);
+
+  // Kick off the first conversion, loop() picks up the result
+  tsl.startConversion();
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, called once 'setup' is complete (your own code
+    should go here)
+*/
+/**************************************************************************/
+void loop(void)
+{
+  // Other work can happen here while the sensor integrates
+  loops++;
+
+  if (tsl.isReady())
+  {
+    uint32_t lum = tsl.readResult();
+    uint16_t ir, full;
+    ir = lum >> 16;
+    full = lum & 0xFFFF;
+    Serial.print(F("[ ")); Serial.print(millis()); Serial.print(F(" ms ] "));
+    Serial.print(F("Loops while waiting: ")); Serial.print(loops); Serial.print(F("  "));
+    Serial.print(F("Lux: ")); Serial.println(tsl.calculateLux(full, ir), 6);
+    loops = 0;
+
+    // Start the next one
+    tsl.startConversion();
+  }
+
+  delay(10);
+}
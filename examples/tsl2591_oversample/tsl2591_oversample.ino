@@ -0,0 +1,84 @@
+/* TSL2591 Digital Light Sensor, oversampling example */
+/* Dynamic Range: 600M:1 */
+/* Maximum Lux: 88K */
+
+/*  For dim light, where single readings are only a few counts and noisy.
+ *  The sensor runs in continuous mode and every conversion is added to
+ *  32-bit channel sums, with no time lost between conversions. Every
+ *  DECIMATION conversions pollOversampled() hands out the sums, and the
+ *  mean lux is worked out from them.
+ */
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include "Adafruit_TSL2591.h"
+
+// Example for demonstrating the TSL2591 library - public domain!
+
+// connect SCL to I2C Clock
+// connect SDA to I2C Data
+// connect Vin to 3.3-5V DC
+// connect GROUND to common ground
+
+#define DECIMATION (8)
+
+Adafruit_TSL2591 tsl = Adafruit_TSL2591(2591); // pass in a number for the sensor identifier (for your use later)
+
+/**************************************************************************/
+/*
+    Program entry point for the Arduino sketch
+*/
+/**************************************************************************/
+void setup(void)
+{
+  Serial.begin(9600);
+
+  Serial.println(F("Starting Adafruit TSL2591 oversampling Test!"));
+
+  if (tsl.begin())
+  {
+    Serial.println(F("Found a TSL2591 sensor"));
+  }
+  else
+  {
+    Serial.println(F("No sensor found ... check your wiring?"));
+    while (1);
+  }
+
+  tsl.setGain(TSL2591_GAIN_MAX);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+
+  // Sum DECIMATION conversions into each result
+  tsl.startOversampling(DECIMATION);
+}
+
+/**************************************************************************/
+/*
+    Arduino loop function, called once 'setup' is complete (your own code
+    should go here)
+*/
+/**************************************************************************/
+void loop(void)
+{
+  tsl2591Oversample_t sums;
+
+  // Call at least once per integration period so no conversion is missed
+  if (tsl.pollOversampled(&sums))
+  {
+    int32_t mlux = Adafruit_TSL2591::calculateLuxMilli(&sums);
+    Serial.print(F("[ ")); Serial.print(millis()); Serial.print(F(" ms ] "));
+    Serial.print(F("Conversions: ")); Serial.print(sums.count); Serial.print(F("  "));
+    Serial.print(F("CH0 sum: ")); Serial.print(sums.ch0); Serial.print(F("  "));
+    Serial.print(F("CH1 sum: ")); Serial.print(sums.ch1); Serial.print(F("  "));
+    if (mlux < 0)
+    {
+      Serial.println(F("Saturated, too bright for max gain"));
+    }
+    else
+    {
+      Serial.print(F("Lux: ")); Serial.println(mlux / 1000.0F, 3);
+    }
+  }
+
+  delay(10);
+}
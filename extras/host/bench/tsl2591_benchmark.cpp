@@ -0,0 +1,159 @@
+/**************************************************************************/
+/*!
+    @file     tsl2591_benchmark.cpp
+
+    Host build of the tsl2591_benchmark sketch. The sketch runs against the
+   simulated sensor, so its bus columns (transactions, bytes, bus_us) are
+   exact and its wait_us column is simulated time. The simulated clock does
+   not move while the CPU computes, so the sketch is timed with that clock
+   plus a real one: cpu_us is host CPU time, which for calls that touch the
+   bus includes the simulated sensor's own cost. A second table measures
+   lux conversion throughput on the host with the real clock alone.
+*/
+/**************************************************************************/
+
+#include <TSL2591Sim.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+/// Real time the process started, for benchMicros()
+static const std::chrono::steady_clock::time_point benchEpoch =
+    std::chrono::steady_clock::now();
+
+/**************************************************************************/
+/*!
+    @brief  Simulated time plus real time, so a row's wall time covers both
+   the simulated bus and conversions and the CPU time of the call
+    @returns Microseconds
+*/
+/**************************************************************************/
+static uint32_t benchMicros(void) {
+  std::chrono::microseconds real =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - benchEpoch);
+  return (uint32_t)(hostMicros() + real.count());
+}
+
+// Enough iterations for sub-microsecond calls to show, simulated waits cost
+// no real time
+#define ITERATIONS (1000)
+#define BENCH_MICROS() benchMicros()
+
+#include "tsl2591_benchmark.ino"
+
+#define LUX_SAMPLES (4096) ///< Raw words per throughput pass
+#define LUX_PASSES (64)    ///< Passes per formula, the fastest one counts
+
+static uint32_t luxRaw[LUX_SAMPLES];  ///< Synthetic log of raw readings
+static int32_t luxMilli[LUX_SAMPLES]; ///< Conversion results
+static volatile int32_t luxSink;      ///< Keeps results observable
+
+/// Converts the whole log once with one of the formulas
+typedef void (*luxPass_t)(void);
+
+static void passScalar(void) {
+  for (uint32_t n = 0; n < LUX_SAMPLES; n++) {
+    luxMilli[n] = Adafruit_TSL2591::calculateLuxMilli(
+        luxRaw[n] & 0xFFFF, luxRaw[n] >> 16, TSL2591_GAIN_MED,
+        TSL2591_INTEGRATIONTIME_100MS);
+  }
+}
+
+static void passBatch(void) {
+  Adafruit_TSL2591::calculateLuxMilli(luxRaw, luxMilli, LUX_SAMPLES,
+                                      TSL2591_GAIN_MED,
+                                      TSL2591_INTEGRATIONTIME_100MS);
+}
+
+template <tsl2591BatchPath_t Path> static void passPath(void) {
+  tsl2591LuxMilliBatch(luxRaw, luxMilli, LUX_SAMPLES,
+                       TSL2591_GAIN_MED | TSL2591_INTEGRATIONTIME_100MS, 1.0F,
+                       TSL2591_LUX_ALGORITHM, Path);
+}
+
+template <class Lux> static void passFixed(void) {
+  for (uint32_t n = 0; n < LUX_SAMPLES; n++) {
+    luxMilli[n] = Lux::calculateLuxMilli(luxRaw[n] & 0xFFFF, luxRaw[n] >> 16);
+  }
+}
+
+static void passFloat(void) {
+  for (uint32_t n = 0; n < LUX_SAMPLES; n++) {
+    float lux = tsl.calculateLux(luxRaw[n] & 0xFFFF, luxRaw[n] >> 16);
+    luxMilli[n] = (int32_t)(lux * 1000);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Times one formula and prints its throughput row
+    @param  name Row label
+    @param  pass Converts the log once
+*/
+/**************************************************************************/
+static void luxThroughput(const char *name, luxPass_t pass) {
+  double best = 0;
+  for (uint8_t p = 0; p < LUX_PASSES; p++) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    pass();
+    std::chrono::duration<double, std::nano> took =
+        std::chrono::steady_clock::now() - start;
+    luxSink = luxMilli[p];
+    if ((p == 0) || (took.count() < best)) {
+      best = took.count();
+    }
+  }
+  double ns = best / LUX_SAMPLES;
+  printf("%s,%d,%.2f,%.1f\n", name, LUX_SAMPLES, ns, 1000.0 / ns);
+}
+
+int main(int argc, char **argv) {
+  TSL2591Sim sim;
+  sim.setLight(40, 8);
+  Wire.attach(&sim);
+  setup();
+  Wire.detach(&sim);
+
+  // Light levels spread over the whole range, CH1 a varying share of CH0
+  uint32_t seed = 1;
+  for (uint32_t n = 0; n < LUX_SAMPLES; n++) {
+    seed = seed * 1103515245UL + 12345;
+    uint16_t ch0 = seed >> 16;
+    uint16_t ch1 = (uint32_t)ch0 * ((seed >> 8) & 0xFF) / 400;
+    luxRaw[n] = (uint32_t)ch1 << 16 | ch0;
+  }
+
+  // A smoke run (ctest) only checks that every row works
+  bool quick = (argc > 1) && !strcmp(argv[1], "--quick");
+  if (quick) {
+    return 0;
+  }
+
+  printf("lux,samples,ns_per_sample,msamples_per_s\n");
+  luxThroughput("calculateLux(float)", passFloat);
+  luxThroughput("calculateLuxMilli", passScalar);
+  luxThroughput("calculateLuxMilli(batch)", passBatch);
+  // One row per SIMD path of the batch conversion this CPU has
+  static const struct {
+    const char *name;
+    tsl2591BatchPath_t path;
+    luxPass_t pass;
+  } paths[4] = {
+      {"batch(scalar)", TSL2591_BATCH_SCALAR, passPath<TSL2591_BATCH_SCALAR>},
+      {"batch(sse4.2)", TSL2591_BATCH_SSE42, passPath<TSL2591_BATCH_SSE42>},
+      {"batch(avx2)", TSL2591_BATCH_AVX2, passPath<TSL2591_BATCH_AVX2>},
+      {"batch(neon)", TSL2591_BATCH_NEON, passPath<TSL2591_BATCH_NEON>},
+  };
+  for (uint8_t p = 0; p < 4; p++) {
+    if (tsl2591LuxBatchSupported(paths[p].path)) {
+      luxThroughput(paths[p].name, paths[p].pass);
+    }
+  }
+  luxThroughput("luxAms", passFixed<LuxAms>);
+  luxThroughput("luxAlt1", passFixed<LuxAlt1>);
+  luxThroughput("luxAlt2", passFixed<LuxAlt2>);
+  return 0;
+}
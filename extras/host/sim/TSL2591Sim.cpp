@@ -0,0 +1,420 @@
+/**************************************************************************/
+/*!
+    @file     TSL2591Sim.cpp
+
+    Register level models of a TSL2591 and a TCA9548A mux
+*/
+/**************************************************************************/
+
+#include "TSL2591Sim.h"
+
+/// Analog gain of each AGAIN setting
+static const float simGain[4] = {1.0F, 25.0F, 428.0F, 9876.0F};
+
+/**************************************************************************/
+/*!
+    @brief  Consecutive out of range cycles a PERSIST setting waits for
+    @param  persist PERSIST register value
+    @returns 0 for every cycle, then 1, 2, 3, 5, 10 ... 60
+*/
+/**************************************************************************/
+static uint8_t simPersist(uint8_t persist) {
+  persist &= 0x0F;
+  return (persist < 4) ? persist : (persist - 3) * 5;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates a powered down TSL2591 in the dark
+    @param  addr 7 bit address it answers on
+*/
+/**************************************************************************/
+TSL2591Sim::TSL2591Sim(uint8_t addr) {
+  _addr = addr;
+  _id = TSL2591_SIM_ID;
+  _fail = 0;
+  _ch0Rate = 0;
+  _ch1Rate = 0;
+  _stepUs = TSL2591_SIM_STEP_US;
+  _cycles = 0;
+  powerOnReset();
+}
+
+HostI2CTarget *TSL2591Sim::select(uint8_t addr) {
+  if (addr != _addr) {
+    return NULL;
+  }
+  if (_fail) {
+    // NACK the address, as a part that is not there
+    _fail--;
+    return NULL;
+  }
+  return this;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Handles a write: a command byte, then data for the registers
+   from the command's address on (auto-increment)
+    @param  data Command byte and register data
+    @param  len Number of bytes, 0 for an address probe
+    @returns True, the part ACKs every byte
+*/
+/**************************************************************************/
+bool TSL2591Sim::receive(const uint8_t *data, size_t len) {
+  update();
+  if (!len) {
+    return true;
+  }
+
+  uint8_t command = data[0];
+  if ((command & 0x80) == 0) {
+    // Not a command, the part ignores it
+    return true;
+  }
+  if ((command & 0x60) == 0x60) {
+    // Special function
+    switch (command & 0x1F) {
+    case 0x04: // Interrupt set
+      _regs[0x13] |= 0x10;
+      break;
+    case 0x06: // Clear ALS interrupt
+      _regs[0x13] &= ~0x10;
+      break;
+    case 0x07: // Clear ALS and no persist ALS interrupt
+      _regs[0x13] &= ~0x30;
+      break;
+    case 0x0A: // Clear no persist ALS interrupt
+      _regs[0x13] &= ~0x20;
+      break;
+    }
+    return true;
+  }
+
+  _pointer = command & 0x1F;
+  for (size_t i = 1; i < len; i++) {
+    writeRegister(_pointer, data[i]);
+    _pointer = (_pointer + 1) & 0x1F;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Handles a read from the register pointer on (auto-increment)
+    @param  data Filled with the register contents
+    @param  len Number of bytes
+    @returns True
+*/
+/**************************************************************************/
+bool TSL2591Sim::transmit(uint8_t *data, size_t len) {
+  update();
+  for (size_t i = 0; i < len; i++) {
+    data[i] = _regs[_pointer];
+    _pointer = (_pointer + 1) & 0x1F;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the light falling on the sensor
+    @param  ch0 CH0 (IR+Visible) counts per 100ms at low gain
+    @param  ch1 CH1 (IR) counts per 100ms at low gain
+*/
+/**************************************************************************/
+void TSL2591Sim::setLight(float ch0, float ch1) {
+  update();
+  _ch0Rate = ch0;
+  _ch1Rate = ch1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the length of one ATIME step, to model oscillator tolerance
+    @param  us Microseconds, TSL2591_SIM_STEP_US nominally
+*/
+/**************************************************************************/
+void TSL2591Sim::setStepTime(uint32_t us) {
+  update();
+  _stepUs = us;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Changes the ID register, e.g. to model a different part being
+   fitted. It survives powerOnReset().
+    @param  id New ID
+*/
+/**************************************************************************/
+void TSL2591Sim::setId(uint8_t id) {
+  _id = id;
+  _regs[0x12] = id;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes the part NACK its address, as if it was unplugged
+    @param  count Number of transactions to NACK
+*/
+/**************************************************************************/
+void TSL2591Sim::failNext(uint16_t count) { _fail = count; }
+
+/**************************************************************************/
+/*!
+    @brief  Puts every register back to its power-on value, as after a
+   brown-out
+*/
+/**************************************************************************/
+void TSL2591Sim::powerOnReset(void) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[0x12] = _id;
+  _pointer = 0;
+  _running = false;
+  _cycleStart = 0;
+  _cycleControl = 0;
+  _cycleUs = 0;
+  _outside = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a register without going through the bus
+    @param  reg Register address
+    @returns Register contents
+*/
+/**************************************************************************/
+uint8_t TSL2591Sim::peek(uint8_t reg) {
+  update();
+  return _regs[reg & 0x1F];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Level of the INT pin
+    @returns True while the part asserts an enabled interrupt
+*/
+/**************************************************************************/
+bool TSL2591Sim::interrupt(void) {
+  update();
+  uint8_t enable = _regs[0x00];
+  uint8_t status = _regs[0x13];
+  return ((enable & 0x10) && (status & 0x10)) ||
+         ((enable & 0x80) && (status & 0x20));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Integration cycles completed so far
+    @returns Cycle count, never reset
+*/
+/**************************************************************************/
+uint32_t TSL2591Sim::cycles(void) {
+  update();
+  return _cycles;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Counts one cycle with a setting produces for the current light,
+   clipped to the analog and digital limits
+    @param  control CONTROL value (gain | integration)
+    @param  ir True for CH1, false for CH0
+    @returns Channel counts
+*/
+/**************************************************************************/
+uint32_t TSL2591Sim::counts(uint8_t control, bool ir) {
+  uint8_t steps = (control & 0x07) + 1;
+  if (steps > 6) {
+    steps = 6;
+  }
+  float c = (ir ? _ch1Rate : _ch0Rate) * simGain[(control >> 4) & 3] * steps;
+  float limit = (steps == 1) ? 37888.0F : 65535.0F;
+  if (c > limit) {
+    c = limit;
+  }
+  return (c > 0) ? (uint32_t)c : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Completes every integration cycle that ended by now
+*/
+/**************************************************************************/
+void TSL2591Sim::update(void) {
+  uint64_t now = hostMicros();
+  while (_running) {
+    uint64_t end = _cycleStart + _cycleUs;
+    if (end > now) {
+      break;
+    }
+    completeCycle();
+    startCycle(end);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Latches the channel data of the cycle that just ended and runs
+   the interrupt logic on CH0
+*/
+/**************************************************************************/
+void TSL2591Sim::completeCycle(void) {
+  uint16_t ch0 = counts(_cycleControl, false);
+  uint16_t ch1 = counts(_cycleControl, true);
+  _regs[0x14] = ch0;
+  _regs[0x15] = ch0 >> 8;
+  _regs[0x16] = ch1;
+  _regs[0x17] = ch1 >> 8;
+  _regs[0x13] |= 0x01;
+  _cycles++;
+
+  uint16_t low = _regs[0x05] << 8 | _regs[0x04];
+  uint16_t high = _regs[0x07] << 8 | _regs[0x06];
+  uint8_t persist = simPersist(_regs[0x0C]);
+  if ((ch0 < low) || (ch0 > high)) {
+    if (_outside < 0xFF) {
+      _outside++;
+    }
+  } else {
+    _outside = 0;
+  }
+  if ((persist == 0) || (_outside >= persist)) {
+    _regs[0x13] |= 0x10;
+  }
+
+  uint16_t npLow = _regs[0x09] << 8 | _regs[0x08];
+  uint16_t npHigh = _regs[0x0B] << 8 | _regs[0x0A];
+  if ((ch0 < npLow) || (ch0 > npHigh)) {
+    _regs[0x13] |= 0x20;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts an integration cycle, with the CONTROL settings and step
+   time at that moment. Changing either mid cycle only affects the next one.
+    @param  now Start time on the simulated clock
+*/
+/**************************************************************************/
+void TSL2591Sim::startCycle(uint64_t now) {
+  _cycleStart = now;
+  _cycleControl = _regs[0x01];
+  _cycleUs = (uint32_t)((_cycleControl & 0x07) + 1) * _stepUs;
+}
+
+void TSL2591Sim::writeRegister(uint8_t reg, uint8_t value) {
+  switch (reg) {
+  case 0x00: {
+    bool was = _running;
+    _regs[0x00] = value & 0xD3;
+    _running = (value & 0x03) == 0x03;
+    if (_running && !was) {
+      // AVALID reports a cycle completed since AEN was asserted
+      _regs[0x13] &= ~0x01;
+      _outside = 0;
+      startCycle(hostMicros());
+    }
+    break;
+  }
+  case 0x01:
+    if (value & 0x80) {
+      powerOnReset();
+    } else {
+      _regs[0x01] = value & 0x37;
+    }
+    break;
+  case 0x04:
+  case 0x05:
+  case 0x06:
+  case 0x07:
+  case 0x08:
+  case 0x09:
+  case 0x0A:
+  case 0x0B:
+    _regs[reg] = value;
+    break;
+  case 0x0C:
+    _regs[0x0C] = value & 0x0F;
+    break;
+  default:
+    // Read only or reserved
+    break;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiates a mux with every channel off
+    @param  addr 7 bit address it answers on
+*/
+/**************************************************************************/
+TCA9548ASim::TCA9548ASim(uint8_t addr) {
+  _addr = addr;
+  _control = 0;
+  _fail = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    _channels[i] = NULL;
+  }
+}
+
+HostI2CTarget *TCA9548ASim::select(uint8_t addr) {
+  if (addr == _addr) {
+    return this;
+  }
+  for (uint8_t i = 0; i < 8; i++) {
+    if ((_control & (1 << i)) && _channels[i]) {
+      HostI2CTarget *target = _channels[i]->select(addr);
+      if (target) {
+        return target;
+      }
+    }
+  }
+  return NULL;
+}
+
+bool TCA9548ASim::receive(const uint8_t *data, size_t len) {
+  if (_fail) {
+    // NACK the control byte, the channels stay as they were
+    _fail--;
+    return false;
+  }
+  if (len) {
+    _control = data[len - 1];
+  }
+  return true;
+}
+
+bool TCA9548ASim::transmit(uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    data[i] = _control;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Connects a device to a downstream channel
+    @param  channel Channel number, 0..7
+    @param  target The device
+*/
+/**************************************************************************/
+void TCA9548ASim::attach(uint8_t channel, HostI2CTarget *target) {
+  _channels[channel & 7] = target;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes the next writes fail, as a mux that glitched
+    @param  count Number of writes to NACK
+*/
+/**************************************************************************/
+void TCA9548ASim::failNext(uint16_t count) { _fail = count; }
+
+/**************************************************************************/
+/*!
+    @brief  Getter for the control register
+    @returns Bit n set while channel n is connected
+*/
+/**************************************************************************/
+uint8_t TCA9548ASim::control(void) { return _control; }
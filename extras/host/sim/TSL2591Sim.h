@@ -0,0 +1,92 @@
+/**************************************************************************/
+/*!
+    @file     TSL2591Sim.h
+
+    Register level models of a TSL2591 and a TCA9548A mux, for running the
+    driver on a host against the host TwoWire. The TSL2591 model runs its
+    integration cycles on the simulated clock: channel data, AVALID and the
+    interrupt flags only change when a cycle completes, so the driver's
+    timing assumptions are exercised the same way as on a real part.
+*/
+/**************************************************************************/
+
+#ifndef _TSL2591_SIM_H_
+#define _TSL2591_SIM_H_
+
+#include <Wire.h>
+
+#define TSL2591_SIM_ID (0x50)        ///< ID register of a TSL2591
+#define TSL2591_SIM_STEP_US (100000) ///< Nominal length of one ATIME step
+
+/**************************************************************************/
+/*!
+    @brief  Simulated TSL2591
+*/
+/**************************************************************************/
+class TSL2591Sim : public HostI2CTarget {
+public:
+  TSL2591Sim(uint8_t addr = 0x29);
+
+  HostI2CTarget *select(uint8_t addr);
+  bool receive(const uint8_t *data, size_t len);
+  bool transmit(uint8_t *data, size_t len);
+
+  void setLight(float ch0, float ch1);
+  void setStepTime(uint32_t us);
+  void setId(uint8_t id);
+  void failNext(uint16_t count);
+  void powerOnReset(void);
+
+  uint8_t peek(uint8_t reg);
+  bool interrupt(void);
+  uint32_t cycles(void);
+  uint32_t counts(uint8_t control, bool ir);
+
+private:
+  void update(void);
+  void completeCycle(void);
+  void startCycle(uint64_t now);
+  void writeRegister(uint8_t reg, uint8_t value);
+
+  uint8_t _addr;
+  uint8_t _id;
+  uint8_t _regs[0x20];
+  uint8_t _pointer;
+  uint16_t _fail;
+  float _ch0Rate;
+  float _ch1Rate;
+  uint32_t _stepUs;
+  bool _running;
+  uint64_t _cycleStart;
+  uint8_t _cycleControl;
+  uint32_t _cycleUs;
+  uint32_t _cycles;
+  uint8_t _outside;
+};
+
+/**************************************************************************/
+/*!
+    @brief  Simulated TCA9548A style I2C mux, one control byte with a bit
+   per downstream channel
+*/
+/**************************************************************************/
+class TCA9548ASim : public HostI2CTarget {
+public:
+  TCA9548ASim(uint8_t addr = 0x70);
+
+  HostI2CTarget *select(uint8_t addr);
+  bool receive(const uint8_t *data, size_t len);
+  bool transmit(uint8_t *data, size_t len);
+
+  void attach(uint8_t channel, HostI2CTarget *target);
+  void failNext(uint16_t count);
+  uint8_t control(void);
+
+private:
+  uint8_t _addr;
+  uint8_t _control;
+  uint16_t _fail;
+  HostI2CTarget *_channels[8];
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_I2CDevice.cpp
+
+    Host build of the Adafruit BusIO I2C device
+*/
+/**************************************************************************/
+
+#include "Adafruit_I2CDevice.h"
+
+Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire) {
+  _addr = addr;
+  _wire = theWire;
+  _begun = false;
+  _maxBufferSize = HOST_WIRE_BUFFER;
+}
+
+uint8_t Adafruit_I2CDevice::address(void) { return _addr; }
+
+/**************************************************************************/
+/*!
+    @brief  Initializes the bus and, like BusIO, probes the address with an
+   empty write
+    @param  addr_detect Whether to probe the address
+    @returns True if the device answered (or was not probed)
+*/
+/**************************************************************************/
+bool Adafruit_I2CDevice::begin(bool addr_detect) {
+  _wire->begin();
+  _begun = true;
+  if (addr_detect) {
+    return detected();
+  }
+  return true;
+}
+
+void Adafruit_I2CDevice::end(void) {
+  _wire->end();
+  _begun = false;
+}
+
+bool Adafruit_I2CDevice::detected(void) {
+  if (!_begun && !begin()) {
+    return false;
+  }
+  _wire->beginTransmission(_addr);
+  return _wire->endTransmission() == 0;
+}
+
+bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
+                               const uint8_t *prefix_buffer,
+                               size_t prefix_len) {
+  if ((len + prefix_len) > maxBufferSize()) {
+    return false;
+  }
+
+  _wire->beginTransmission(_addr);
+  if ((prefix_len != 0) && (prefix_buffer != NULL)) {
+    if (_wire->write(prefix_buffer, prefix_len) != prefix_len) {
+      return false;
+    }
+  }
+  if (_wire->write(buffer, len) != len) {
+    return false;
+  }
+  return _wire->endTransmission(stop) == 0;
+}
+
+bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  size_t pos = 0;
+  while (pos < len) {
+    size_t chunk = len - pos;
+    if (chunk > maxBufferSize()) {
+      chunk = maxBufferSize();
+    }
+    bool last = (pos + chunk) >= len;
+    if (!_read(buffer + pos, chunk, last && stop)) {
+      return false;
+    }
+    pos += chunk;
+  }
+  return true;
+}
+
+bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
+  size_t recv = _wire->requestFrom(_addr, (uint8_t)len, stop);
+  if (recv != len) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    buffer[i] = _wire->read();
+  }
+  return true;
+}
+
+bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
+                                         size_t write_len,
+                                         uint8_t *read_buffer,
+                                         size_t read_len, bool stop) {
+  if (!write(write_buffer, write_len, stop)) {
+    return false;
+  }
+  return read(read_buffer, read_len);
+}
+
+bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk) {
+  _wire->setClock(desiredclk);
+  return true;
+}
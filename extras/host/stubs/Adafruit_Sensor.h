@@ -0,0 +1,67 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_Sensor.h
+
+    Host build of the Adafruit Unified Sensor types the driver uses
+*/
+/**************************************************************************/
+
+#ifndef _ADAFRUIT_SENSOR_H
+#define _ADAFRUIT_SENSOR_H
+
+#include <Arduino.h>
+
+/// Sensor types
+typedef enum {
+  SENSOR_TYPE_LIGHT = (5),
+} sensors_type_t;
+
+/// Sensor event (36 bytes)
+typedef struct {
+  int32_t version;   ///< must be sizeof(struct sensors_event_t)
+  int32_t sensor_id; ///< unique sensor identifier
+  int32_t type;      ///< sensor type
+  int32_t reserved0; ///< reserved
+  int32_t timestamp; ///< time is in milliseconds
+  /// Union for the wide ranges of data we can carry
+  union {
+    float data[4]; ///< Raw data
+    float light;   ///< light in SI lux units
+  };
+} sensors_event_t;
+
+/// Sensor details (40 bytes)
+typedef struct {
+  char name[12];     ///< sensor name
+  int32_t version;   ///< version of the hardware + driver
+  int32_t sensor_id; ///< unique sensor identifier
+  int32_t type;      ///< this sensor's type (ex. SENSOR_TYPE_LIGHT)
+  float max_value;   ///< maximum value of this sensor's value in SI units
+  float min_value;   ///< minimum value of this sensor's value in SI units
+  float resolution;  ///< smallest difference between two values
+  int32_t min_delay; ///< min delay in microseconds between events
+} sensor_t;
+
+/** @brief Common sensor interface to unify various sensors. */
+class Adafruit_Sensor {
+public:
+  // Constructor(s)
+  Adafruit_Sensor() {}
+  virtual ~Adafruit_Sensor() {}
+
+  // These must be defined by the subclass
+
+  /*! @brief Whether we should automatically change the range (if possible)
+      for higher precision
+      @param enabled True if we will try to autorange */
+  virtual void enableAutoRange(bool enabled) { (void)enabled; };
+
+  /*! @brief Get the latest sensor event
+      @returns True if able to fetch an event */
+  virtual bool getEvent(sensors_event_t *) = 0;
+
+  /*! @brief Get info about the sensor itself */
+  virtual void getSensor(sensor_t *) = 0;
+};
+
+#endif
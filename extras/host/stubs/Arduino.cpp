@@ -0,0 +1,103 @@
+/**************************************************************************/
+/*!
+    @file     Arduino.cpp
+
+    Simulated clock behind the host Arduino core
+*/
+/**************************************************************************/
+
+#include "Arduino.h"
+
+#include <stdio.h>
+
+static uint64_t hostClock = 0;
+static bool hostInterrupts = true;
+
+unsigned long millis(void) { return (uint32_t)(hostClock / 1000); }
+
+unsigned long micros(void) { return (uint32_t)hostClock; }
+
+void delay(unsigned long ms) { hostClock += (uint64_t)ms * 1000; }
+
+void delayMicroseconds(unsigned int us) { hostClock += us; }
+
+void yield(void) {}
+
+void noInterrupts(void) { hostInterrupts = false; }
+
+void interrupts(void) { hostInterrupts = true; }
+
+/**************************************************************************/
+/*!
+    @brief  Moves the simulated clock forward, e.g. for time spent on the bus
+    @param  us Microseconds to advance
+*/
+/**************************************************************************/
+void hostAdvance(uint32_t us) { hostClock += us; }
+
+/**************************************************************************/
+/*!
+    @brief  Reads the simulated clock without wrapping
+    @returns Microseconds since the clock was last reset
+*/
+/**************************************************************************/
+uint64_t hostMicros(void) { return hostClock; }
+
+/**************************************************************************/
+/*!
+    @brief  Sets the simulated clock back to 0
+*/
+/**************************************************************************/
+void hostResetClock(void) { hostClock = 0; }
+
+/**************************************************************************/
+/*!
+    @brief  Tells whether noInterrupts() is in effect
+    @returns False between noInterrupts() and interrupts()
+*/
+/**************************************************************************/
+bool hostInterruptsEnabled(void) { return hostInterrupts; }
+
+HostSerial Serial;
+
+void HostSerial::begin(unsigned long baud) { (void)baud; }
+
+void HostSerial::print(const char *s) { fputs(s, stdout); }
+
+void HostSerial::print(const __FlashStringHelper *s) {
+  fputs(reinterpret_cast<const char *>(s), stdout);
+}
+
+void HostSerial::print(char c) { putchar(c); }
+
+void HostSerial::print(long n, int base) {
+  if (base == 16) {
+    printf("%lX", (unsigned long)n);
+  } else {
+    printf("%ld", n);
+  }
+}
+
+void HostSerial::print(unsigned long n, int base) {
+  printf((base == 16) ? "%lX" : "%lu", n);
+}
+
+void HostSerial::print(int n, int base) { print((long)n, base); }
+
+void HostSerial::print(unsigned int n, int base) {
+  print((unsigned long)n, base);
+}
+
+void HostSerial::print(double n, int digits) { printf("%.*f", digits, n); }
+
+void HostSerial::println(void) { putchar('\n'); }
+
+void HostSerial::println(const char *s) {
+  print(s);
+  println();
+}
+
+void HostSerial::println(const __FlashStringHelper *s) {
+  print(s);
+  println();
+}
@@ -0,0 +1,74 @@
+/**************************************************************************/
+/*!
+    @file     Arduino.h
+
+    Minimal Arduino core for building the TSL2591 library on a host. Time
+    is simulated: millis() and micros() read a clock that only moves when
+    delay(), delayMicroseconds() or bus traffic advance it, so tests and
+    benchmarks are deterministic and run much faster than real time.
+*/
+/**************************************************************************/
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean; ///< Arduino boolean type
+typedef uint8_t byte; ///< Arduino byte type
+
+#define PROGMEM ///< Data lives in RAM on the host
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))   ///< Reads PROGMEM
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))  ///< Reads PROGMEM
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr)) ///< Reads PROGMEM
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s)) ///< Flash text
+
+#define DEC 10 ///< Decimal output for print()
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+void noInterrupts(void);
+void interrupts(void);
+
+/**************************************************************************/
+/*!
+    @brief  Serial port that writes to stdout, the print() and println()
+   overloads the examples use
+*/
+/**************************************************************************/
+class HostSerial {
+public:
+  void begin(unsigned long baud);
+  void print(const char *s);
+  void print(const __FlashStringHelper *s);
+  void print(char c);
+  void print(long n, int base = DEC);
+  void print(unsigned long n, int base = DEC);
+  void print(int n, int base = DEC);
+  void print(unsigned int n, int base = DEC);
+  void print(double n, int digits = 2);
+  void println(void);
+  void println(const char *s);
+  void println(const __FlashStringHelper *s);
+  operator bool(void) { return true; } ///< Always connected
+};
+
+extern HostSerial Serial; ///< stdout
+
+// Simulated clock control, not part of the Arduino API
+void hostAdvance(uint32_t us);
+uint64_t hostMicros(void);
+void hostResetClock(void);
+bool hostInterruptsEnabled(void);
+
+#endif
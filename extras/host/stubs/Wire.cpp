@@ -0,0 +1,154 @@
+/**************************************************************************/
+/*!
+    @file     Wire.cpp
+
+    Host TwoWire, routes transactions to simulated I2C targets
+*/
+/**************************************************************************/
+
+#include "Wire.h"
+
+#include <algorithm>
+
+TwoWire Wire;
+
+TwoWire::TwoWire(void) {
+  recording = false;
+  transactions = 0;
+  _clock = 100000;
+  _addr = 0;
+  _txLen = 0;
+  _rxLen = 0;
+  _rxPos = 0;
+}
+
+void TwoWire::begin(void) {}
+
+void TwoWire::end(void) {}
+
+void TwoWire::setClock(uint32_t hz) { _clock = hz ? hz : 100000; }
+
+void TwoWire::beginTransmission(uint8_t addr) {
+  _addr = addr;
+  _txLen = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (_txLen >= sizeof(_tx)) {
+    return 0;
+  }
+  _tx[_txLen++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len) {
+  size_t n = 0;
+  while ((n < len) && write(data[n])) {
+    n++;
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends the buffered write transaction
+    @param  stop Unused, the simulated targets do not care about repeated
+   starts
+    @returns 0 on success, 2 if the address was NACKed, 3 if the data was
+*/
+/**************************************************************************/
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void)stop;
+  HostI2CTarget *target = find(_addr);
+  bool ack = target && target->receive(_tx, _txLen);
+  record(_addr, false, ack, _tx, _txLen);
+  if (!target) {
+    return 2;
+  }
+  return ack ? 0 : 3;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs a read transaction
+    @param  addr 7 bit address
+    @param  len Bytes to read, at most HOST_WIRE_BUFFER
+    @param  stop Unused
+    @returns Bytes read, 0 if the target NACKed
+*/
+/**************************************************************************/
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t len, bool stop) {
+  (void)stop;
+  if (len > sizeof(_rx)) {
+    len = sizeof(_rx);
+  }
+  HostI2CTarget *target = find(addr);
+  bool ack = target && target->transmit(_rx, len);
+  record(addr, true, ack, _rx, ack ? len : 0);
+  _rxPos = 0;
+  _rxLen = ack ? len : 0;
+  return _rxLen;
+}
+
+int TwoWire::available(void) { return (int)(_rxLen - _rxPos); }
+
+int TwoWire::read(void) { return (_rxPos < _rxLen) ? _rx[_rxPos++] : -1; }
+
+/**************************************************************************/
+/*!
+    @brief  Puts a simulated device on the bus
+    @param  target The device, it must outlive its time on the bus
+*/
+/**************************************************************************/
+void TwoWire::attach(HostI2CTarget *target) { _targets.push_back(target); }
+
+/**************************************************************************/
+/*!
+    @brief  Takes a simulated device off the bus
+    @param  target The device
+*/
+/**************************************************************************/
+void TwoWire::detach(HostI2CTarget *target) {
+  _targets.erase(std::remove(_targets.begin(), _targets.end(), target),
+                 _targets.end());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Time a transaction takes on the wire: start, address byte, the
+   data bytes (9 clocks each with the ACK) and stop
+    @param  bytes Data bytes after the address
+    @returns Microseconds at the current clock rate
+*/
+/**************************************************************************/
+uint32_t TwoWire::busTime(size_t bytes) {
+  uint32_t bits = 2 + 9 * (1 + (uint32_t)bytes);
+  return (uint32_t)(((uint64_t)bits * 1000000 + _clock - 1) / _clock);
+}
+
+HostI2CTarget *TwoWire::find(uint8_t addr) {
+  for (size_t i = 0; i < _targets.size(); i++) {
+    HostI2CTarget *target = _targets[i]->select(addr);
+    if (target) {
+      return target;
+    }
+  }
+  return NULL;
+}
+
+void TwoWire::record(uint8_t addr, bool read, bool ack, const uint8_t *data,
+                     size_t len) {
+  uint32_t duration = busTime(ack ? len : 0);
+  if (recording) {
+    HostI2CRecord r;
+    r.timestamp = hostMicros();
+    r.duration = duration;
+    r.addr = addr;
+    r.read = read;
+    r.ack = ack;
+    r.data.assign(data, data + len);
+    log.push_back(r);
+  }
+  transactions++;
+  hostAdvance(duration);
+}
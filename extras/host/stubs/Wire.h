@@ -0,0 +1,117 @@
+/**************************************************************************/
+/*!
+    @file     Wire.h
+
+    Host TwoWire that routes transactions to simulated I2C targets instead
+    of a bus peripheral. Every transaction advances the simulated clock by
+    the time it would take on the wire at the selected clock rate, and can
+    be recorded for tests.
+*/
+/**************************************************************************/
+
+#ifndef _HOST_WIRE_H_
+#define _HOST_WIRE_H_
+
+#include <Arduino.h>
+
+#include <vector>
+
+#define HOST_WIRE_BUFFER (32) ///< Bytes TwoWire buffers, as on AVR
+
+/**************************************************************************/
+/*!
+    @brief  A device the host TwoWire can talk to
+*/
+/**************************************************************************/
+class HostI2CTarget {
+public:
+  virtual ~HostI2CTarget() {}
+
+  /************************************************************************/
+  /*!
+      @brief  Address phase, picks the device that answers
+      @param  addr 7 bit address on the bus
+      @returns The target that acknowledges addr (this one, or one behind
+     it on a mux), or NULL
+  */
+  /************************************************************************/
+  virtual HostI2CTarget *select(uint8_t addr) = 0;
+
+  /************************************************************************/
+  /*!
+      @brief  Receives a write transaction
+      @param  data Bytes sent after the address
+      @param  len Number of bytes, 0 for an address only probe
+      @returns False to NACK the transaction
+  */
+  /************************************************************************/
+  virtual bool receive(const uint8_t *data, size_t len) = 0;
+
+  /************************************************************************/
+  /*!
+      @brief  Serves a read transaction
+      @param  data Filled with the bytes read
+      @param  len Number of bytes requested
+      @returns False to NACK the transaction
+  */
+  /************************************************************************/
+  virtual bool transmit(uint8_t *data, size_t len) = 0;
+};
+
+/// One bus transaction, as seen on the wire
+typedef struct {
+  uint64_t timestamp;        ///< hostMicros() when the transaction started
+  uint32_t duration;         ///< Microseconds on the wire
+  uint8_t addr;              ///< 7 bit address
+  bool read;                 ///< Read (true) or write transaction
+  bool ack;                  ///< False if the target NACKed
+  std::vector<uint8_t> data; ///< Bytes written or read after the address
+} HostI2CRecord;
+
+/**************************************************************************/
+/*!
+    @brief  The subset of the Arduino TwoWire API BusIO uses
+*/
+/**************************************************************************/
+class TwoWire {
+public:
+  TwoWire(void);
+
+  void begin(void);
+  void end(void);
+  void setClock(uint32_t hz);
+  void beginTransmission(uint8_t addr);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t len);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t addr, uint8_t len, bool stop = true);
+  int available(void);
+  int read(void);
+
+  // Host side, not part of the Arduino API
+  void attach(HostI2CTarget *target);
+  void detach(HostI2CTarget *target);
+  uint32_t busTime(size_t bytes);
+
+  bool recording;                 ///< Append every transaction to log
+  std::vector<HostI2CRecord> log; ///< Transactions, while recording is set
+  uint32_t transactions;          ///< Transactions issued so far
+
+private:
+  HostI2CTarget *find(uint8_t addr);
+  void record(uint8_t addr, bool read, bool ack, const uint8_t *data,
+              size_t len);
+
+  std::vector<HostI2CTarget *> _targets;
+  uint32_t _clock;
+  uint8_t _addr;
+  uint8_t _tx[HOST_WIRE_BUFFER];
+  size_t _txLen;
+  uint8_t _rx[HOST_WIRE_BUFFER];
+  size_t _rxLen;
+  size_t _rxPos;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,89 @@
+/**************************************************************************/
+/*!
+    @file     host_test.h
+
+    Minimal checks for the host tests, each test is a plain executable that
+    exits non-zero if any check failed
+*/
+/**************************************************************************/
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <TSL2591Sim.h>
+#include <stdio.h>
+
+static int hostFailures = 0; ///< Checks failed so far
+
+/**************************************************************************/
+/*!
+    @brief  Records the outcome of one check
+    @param  ok Outcome
+    @param  what Source text of the check
+    @param  file Source file
+    @param  line Source line
+*/
+/**************************************************************************/
+static inline void hostCheck(bool ok, const char *what, const char *file,
+                             int line) {
+  if (!ok) {
+    printf("%s:%d: check failed: %s\n", file, line, what);
+    hostFailures++;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Records the outcome of an equality check, printing both values
+    @param  a Actual value
+    @param  b Expected value
+    @param  what Source text of the check
+    @param  file Source file
+    @param  line Source line
+*/
+/**************************************************************************/
+static inline void hostCheckEq(long long a, long long b, const char *what,
+                               const char *file, int line) {
+  if (a != b) {
+    printf("%s:%d: check failed: %s (%lld != %lld)\n", file, line, what, a,
+           b);
+    hostFailures++;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prints the summary for a test executable
+    @param  name Test name
+    @returns Exit code, 0 if every check passed
+*/
+/**************************************************************************/
+static inline int hostTestResult(const char *name) {
+  printf("%s: %s\n", name, hostFailures ? "FAILED" : "passed");
+  return hostFailures ? 1 : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  A simulated TSL2591 on Wire, with the clock and the bus log
+   reset, for the lifetime of the object
+*/
+/**************************************************************************/
+struct HostFixture {
+  TSL2591Sim sim; ///< The sensor
+
+  HostFixture(void) {
+    hostResetClock();
+    Wire.log.clear();
+    Wire.recording = false;
+    Wire.attach(&sim);
+  }
+  ~HostFixture(void) { Wire.detach(&sim); }
+};
+
+#define CHECK(cond) hostCheck((cond), #cond, __FILE__, __LINE__) ///< Check
+#define CHECK_EQ(a, b)                                                         \
+  hostCheckEq((long long)(a), (long long)(b), #a " == " #b, __FILE__,          \
+              __LINE__) ///< Equality check
+
+#endif
@@ -0,0 +1,76 @@
+/**************************************************************************/
+/*!
+    @file     test_autorange.cpp
+
+    Checks the auto-range engine against the simulated sensor
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "host_test.h"
+
+/// CONTROL writes seen by the bus monitor
+static uint32_t controlWrites = 0;
+
+static void monitor(const tsl2591Transaction_t *t, void *context) {
+  (void)context;
+  if ((t->command == (TSL2591_COMMAND_BIT | TSL2591_REGISTER_CONTROL)) &&
+      t->written) {
+    controlWrites++;
+  }
+}
+
+/// Changing gain and integration time together takes one CONTROL write
+static void testSingleWrite(void) {
+  HostFixture f;
+  f.sim.setLight(2, 0.5);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MAX);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_600MS);
+  tsl.setBusMonitor(monitor);
+
+  // A saturated reading drops straight to low gain at 100ms
+  controlWrites = 0;
+  CHECK(tsl.autoRange(0xFFFF));
+  CHECK_EQ(controlWrites, 1);
+  CHECK_EQ(tsl.getGain(), TSL2591_GAIN_LOW);
+  CHECK_EQ(tsl.getTiming(), TSL2591_INTEGRATIONTIME_100MS);
+  CHECK_EQ(f.sim.peek(0x01), 0x00);
+
+  // Already in band, nothing is written
+  controlWrites = 0;
+  CHECK(!tsl.autoRange(10000));
+  CHECK_EQ(controlWrites, 0);
+
+  // The ranged reading lands in the band
+  uint32_t lum = tsl.getAutoRangedLuminosity();
+  CHECK((lum & 0xFFFF) >= TSL2591_AUTORANGE_LOW);
+  CHECK((lum & 0xFFFF) <= TSL2591_AUTORANGE_HIGH);
+}
+
+/// A failed read leaves the settings alone instead of ranging from 0
+static void testFailedRead(void) {
+  HostFixture f;
+  f.sim.setLight(100, 20);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_LOW);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_200MS);
+  tsl.setRetryPolicy(0);
+
+  f.sim.failNext(1000);
+  CHECK_EQ(tsl.getAutoRangedLuminosity(), 0);
+  f.sim.failNext(0);
+  CHECK_EQ(tsl.getGain(), TSL2591_GAIN_LOW);
+  CHECK_EQ(tsl.getTiming(), TSL2591_INTEGRATIONTIME_200MS);
+  tsl2591AutoRange_t decision;
+  tsl.getAutoRangeDecision(&decision);
+  CHECK_EQ(decision.conversions, 1);
+}
+
+int main(void) {
+  testSingleWrite();
+  testFailedRead();
+  return hostTestResult("test_autorange");
+}
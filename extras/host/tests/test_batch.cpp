@@ -0,0 +1,188 @@
+/**************************************************************************/
+/*!
+    @file     test_batch.cpp
+
+    Checks that every batch lux path the CPU supports gives bit identical
+    results to the driver's scalar formulas, at every setting
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "host_test.h"
+
+#include <vector>
+
+/// Batch paths to check, the ones this CPU lacks are skipped
+static const tsl2591BatchPath_t paths[4] = {
+    TSL2591_BATCH_SCALAR, TSL2591_BATCH_SSE42, TSL2591_BATCH_AVX2,
+    TSL2591_BATCH_NEON};
+
+/// Raw words covering the edges of both channels, then random ones
+static std::vector<uint32_t> rawWords(void) {
+  static const uint16_t edges[] = {0,     1,     2,     3,     7,     100,
+                                   1000,  36862, 36863, 36864, 40000, 65533,
+                                   65534, 65535};
+  std::vector<uint32_t> raw;
+  for (uint16_t a : edges) {
+    for (uint16_t b : edges) {
+      raw.push_back((uint32_t)b << 16 | a);
+    }
+  }
+  // Dense near ch0 = 0, where ALT1 divides by the smallest counts
+  for (uint32_t ch0 = 0; ch0 < 16; ch0++) {
+    for (uint32_t ch1 = 0; ch1 < 65536; ch1 += 61) {
+      raw.push_back(ch1 << 16 | ch0);
+    }
+  }
+  uint32_t seed = 1;
+  for (uint32_t n = 0; n < 50000; n++) {
+    seed = seed * 1103515245UL + 12345;
+    uint32_t ch0 = seed >> 16;
+    seed = seed * 1103515245UL + 12345;
+    uint32_t ch1 = (n & 1) ? (seed >> 16) : ch0 * ((seed >> 8) & 0xFF) / 200;
+    raw.push_back((ch1 & 0xFFFF) << 16 | ch0);
+  }
+  return raw;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Scalar reference for one formula, as the driver computes it
+    @param  algorithm TSL2591_LUX_ALGORITHM value
+    @param  raw Raw word
+    @param  k Calibrated lux factor
+    @param  limit Lowest saturated count
+    @returns Milli-lux, or -1 if saturated
+*/
+/**************************************************************************/
+static int32_t reference(uint8_t algorithm, uint32_t raw, uint32_t k,
+                         uint16_t limit) {
+  uint16_t ch0 = raw & 0xFFFF, ch1 = raw >> 16;
+  if ((ch0 >= limit) || (ch1 >= limit)) {
+    return -1;
+  }
+  uint64_t q = (algorithm == TSL2591_LUX_AMS)    ? tsl2591LuxDual(ch0, ch1)
+               : (algorithm == TSL2591_LUX_ALT2) ? tsl2591LuxAlt2(ch0, ch1)
+                                                 : tsl2591LuxAlt1(ch0, ch1);
+  return tsl2591LuxMilli(q, k);
+}
+
+/// Every path, formula and setting against the scalar formulas
+static void testPaths(void) {
+  std::vector<uint32_t> raw = rawWords();
+  std::vector<int32_t> mlux(raw.size());
+  uint8_t checked = 0;
+
+  for (uint8_t p = 0; p < 4; p++) {
+    if (!tsl2591LuxBatchSupported(paths[p])) {
+      continue;
+    }
+    checked++;
+    for (uint8_t control = 0; control < 0x40; control++) {
+      uint8_t integration = control & 0x07;
+      if (integration > TSL2591_INTEGRATIONTIME_600MS) {
+        continue;
+      }
+      tsl2591Gain_t gain = (tsl2591Gain_t)(control & 0x30);
+      uint16_t limit = Adafruit_TSL2591::saturationLimit(
+          (tsl2591IntegrationTime_t)integration);
+      uint32_t k = tsl2591LuxFactor(control);
+
+      for (uint8_t algorithm = 0; algorithm < 3; algorithm++) {
+        CHECK_EQ(tsl2591LuxMilliBatch(raw.data(), mlux.data(), raw.size(),
+                                      control, 1.0F, algorithm, paths[p]),
+                 paths[p]);
+        uint32_t failures = 0;
+        for (size_t n = 0; n < raw.size(); n++) {
+          int32_t expect = reference(algorithm, raw[n], k, limit);
+          if (algorithm == TSL2591_LUX_ALGORITHM) {
+            // The driver's own entry point, for the formula compiled in
+            CHECK_EQ(expect, Adafruit_TSL2591::calculateLuxMilli(
+                                 raw[n] & 0xFFFF, raw[n] >> 16, gain,
+                                 (tsl2591IntegrationTime_t)integration));
+          }
+          if ((mlux[n] != expect) && !failures++) {
+            printf("path %u algorithm %u control 0x%02X raw 0x%08lX: %ld, "
+                   "expected %ld\n",
+                   paths[p], algorithm, control, (unsigned long)raw[n],
+                   (long)mlux[n], (long)expect);
+          }
+        }
+        CHECK_EQ(failures, 0);
+      }
+    }
+  }
+  CHECK(checked >= 1);
+}
+
+/// Calibration folds into the factor, including one past the int32 range
+static void testCalibration(void) {
+  std::vector<uint32_t> raw = rawWords();
+  std::vector<int32_t> scalar(raw.size()), mlux(raw.size());
+  const float calibration[4] = {0.0F, 0.37F, 2.5F, 60000.0F};
+
+  for (uint8_t c = 0; c < 4; c++) {
+    uint8_t control = TSL2591_GAIN_LOW | TSL2591_INTEGRATIONTIME_100MS;
+    tsl2591LuxMilliBatch(raw.data(), scalar.data(), raw.size(), control,
+                         calibration[c], TSL2591_LUX_ALT1,
+                         TSL2591_BATCH_SCALAR);
+    uint32_t k = tsl2591Calibrate(tsl2591LuxFactor(control),
+                                  tsl2591CalibrationQ16(calibration[c]));
+    for (size_t n = 0; n < raw.size(); n += 97) {
+      CHECK_EQ(scalar[n], reference(TSL2591_LUX_ALT1, raw[n], k,
+                                    TSL2591_MAX_COUNT_100MS));
+    }
+
+    for (uint8_t p = 1; p < 4; p++) {
+      if (!tsl2591LuxBatchSupported(paths[p])) {
+        continue;
+      }
+      for (uint8_t algorithm = 0; algorithm < 3; algorithm++) {
+        tsl2591LuxMilliBatch(raw.data(), scalar.data(), raw.size(), control,
+                             calibration[c], algorithm, TSL2591_BATCH_SCALAR);
+        tsl2591LuxMilliBatch(raw.data(), mlux.data(), raw.size(), control,
+                             calibration[c], algorithm, paths[p]);
+        CHECK(scalar == mlux);
+      }
+    }
+  }
+}
+
+/// Tails shorter than a vector and unaligned buffers take the same results
+static void testTails(void) {
+  std::vector<uint32_t> raw = rawWords();
+  std::vector<int32_t> scalar(16), mlux(16);
+  uint8_t control = TSL2591_GAIN_MED | TSL2591_INTEGRATIONTIME_200MS;
+
+  for (uint8_t p = 1; p < 4; p++) {
+    if (!tsl2591LuxBatchSupported(paths[p])) {
+      continue;
+    }
+    for (size_t count = 0; count < 9; count++) {
+      std::fill(mlux.begin(), mlux.end(), 12345);
+      tsl2591LuxMilliBatch(raw.data() + 1, scalar.data(), count, control);
+      tsl2591LuxMilliBatch(raw.data() + 1, mlux.data() + 1, count, control,
+                           1.0F, TSL2591_LUX_ALGORITHM, paths[p]);
+      CHECK_EQ(mlux[0], 12345);
+      CHECK_EQ(mlux[count + 1], 12345);
+      for (size_t n = 0; n < count; n++) {
+        CHECK_EQ(mlux[n + 1], scalar[n]);
+      }
+    }
+  }
+
+  // The driver's batch call is the same conversion
+  Adafruit_TSL2591::calculateLuxMilli(raw.data(), mlux.data(), 16,
+                                      TSL2591_GAIN_MED,
+                                      TSL2591_INTEGRATIONTIME_200MS);
+  tsl2591LuxMilliBatch(raw.data(), scalar.data(), 16, control, 1.0F,
+                       TSL2591_LUX_ALGORITHM, TSL2591_BATCH_SCALAR);
+  CHECK(scalar == mlux);
+}
+
+int main(void) {
+  testPaths();
+  testCalibration();
+  testTails();
+  return hostTestResult("test_batch");
+}
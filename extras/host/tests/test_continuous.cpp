@@ -0,0 +1,154 @@
+/**************************************************************************/
+/*!
+    @file     test_continuous.cpp
+
+    Checks that continuous mode tells new conversions from repeats by the
+    chip's flag, whatever the oscillator does
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "host_test.h"
+
+/**************************************************************************/
+/*!
+    @brief  Polls getLatestLuminosity() every few milliseconds and counts
+   how often the sequence moved
+    @param  tsl The driver, in continuous mode
+    @param  ms Milliseconds to poll for
+    @returns Number of new conversions seen
+*/
+/**************************************************************************/
+static uint32_t pollNew(Adafruit_TSL2591 &tsl, uint32_t ms) {
+  uint32_t seen = 0;
+  uint32_t last = tsl.getSequence();
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    uint32_t seq;
+    tsl.getLatestLuminosity(&seq);
+    if (seq != last) {
+      CHECK_EQ(seq, last + 1);
+      seen++;
+      last = seq;
+    }
+    delay(5);
+  }
+  return seen;
+}
+
+/// One new reading per chip cycle with a slow or a fast oscillator
+static void testOscillator(void) {
+  const uint32_t steps[3] = {TSL2591_SIM_STEP_US, 125000, 85000};
+  for (uint8_t i = 0; i < 3; i++) {
+    HostFixture f;
+    f.sim.setLight(10, 2);
+    f.sim.setStepTime(steps[i]);
+    Adafruit_TSL2591 tsl;
+    Adafruit_TSL2591_SampleRing<32> ring;
+    CHECK(tsl.begin());
+    tsl.setSampleBuffer(&ring);
+    tsl.startContinuous();
+
+    uint32_t seq = 1;
+    CHECK_EQ(tsl.getLatestLuminosity(&seq), 0);
+    CHECK_EQ(seq, 0);
+    uint32_t cycles = f.sim.cycles();
+    uint32_t seen = pollNew(tsl, 2000);
+    CHECK(seen >= 15);
+
+    // Pick up a cycle that ended since the last poll, then every one is in
+    tsl.getLatestLuminosity(&seq);
+    CHECK_EQ(seq, f.sim.cycles() - cycles);
+    CHECK_EQ(ring.count(), seq);
+  }
+}
+
+/// A settings change restarts the ADC, so the next conversion uses them
+static void testSettingsChange(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.startContinuous();
+  uint32_t lum;
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x10, false));
+
+  // Mid cycle: the conversion in flight is dropped, not reported
+  delay(50);
+  tsl.setGain(TSL2591_GAIN_HIGH);
+  uint32_t start = millis();
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK(millis() - start >= 100);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x20, false));
+
+  // Once a conversion completed, reads do not wait
+  start = millis();
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK(millis() - start < 5);
+}
+
+/// Continuous mode borrows the persist filter and hands it back
+static void testPersist(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.registerInterrupt(100, 1500, TSL2591_PERSIST_5);
+  tsl.startContinuous();
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_EVERY);
+
+  tsl.registerInterrupt(100, 1500, TSL2591_PERSIST_10);
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_EVERY);
+  tsl.stopContinuous();
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_10);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+}
+
+/// Oversampling sums every flagged conversion once, and nothing from before
+static void testOversampling(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  f.sim.setStepTime(115000);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.startContinuous();
+  delay(150); // A conversion is flagged, with the old light
+
+  f.sim.setLight(20, 4);
+  tsl.startOversampling(8);
+  tsl2591Oversample_t sums;
+  uint32_t cycles = f.sim.cycles();
+  uint32_t start = millis();
+  while (!tsl.pollOversampled(&sums)) {
+    delay(1);
+    CHECK(millis() - start < 2000);
+  }
+  CHECK_EQ(f.sim.cycles() - cycles, 8);
+  CHECK_EQ(sums.count, 8);
+  CHECK_EQ(sums.ch0, 8 * f.sim.counts(0x10, false));
+  CHECK_EQ(sums.ch1, 8 * f.sim.counts(0x10, true));
+}
+
+/// Outside continuous mode it is a blocking read, with no sequence
+static void testOneShot(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  uint32_t seq = 1;
+  uint32_t lum = tsl.getLatestLuminosity(&seq);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x10, false));
+  CHECK_EQ(lum >> 16, f.sim.counts(0x10, true));
+  CHECK_EQ(seq, 0);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+}
+
+int main(void) {
+  testOscillator();
+  testSettingsChange();
+  testPersist();
+  testOversampling();
+  testOneShot();
+  return hostTestResult("test_continuous");
+}
@@ -0,0 +1,157 @@
+/**************************************************************************/
+/*!
+    @file     test_interrupt.cpp
+
+    Checks interrupt driven sampling against the simulated sensor's INT pin
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "host_test.h"
+
+/**************************************************************************/
+/*!
+    @brief  Runs the simulated clock, calling handleInterrupt() on each
+   falling edge of the INT pin as a pin ISR would
+    @param  sim The sensor
+    @param  tsl Its driver
+    @param  ms Milliseconds to run
+*/
+/**************************************************************************/
+static void runIsr(TSL2591Sim &sim, Adafruit_TSL2591 &tsl, uint32_t ms) {
+  bool level = sim.interrupt();
+  for (uint32_t i = 0; i < ms; i++) {
+    delay(1);
+    bool now = sim.interrupt();
+    if (now && !level) {
+      tsl.handleInterrupt();
+    }
+    level = now;
+  }
+}
+
+/// Each conversion reaches the queue, coalesced interrupts count as dropped
+static void testDataReady(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  Adafruit_TSL2591_SampleFifo<8> queue;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+  tsl.startDataReadyInterrupt(&queue);
+
+  CHECK(!tsl.serviceInterrupt());
+  for (uint8_t i = 0; i < 3; i++) {
+    runIsr(f.sim, tsl, 100);
+    CHECK(tsl.serviceInterrupt());
+    CHECK(hostInterruptsEnabled());
+  }
+  CHECK_EQ(queue.available(), 3);
+  CHECK_EQ(queue.dropped(), 0);
+  tsl2591Sample_t sample;
+  CHECK(queue.pop(&sample));
+  CHECK_EQ(sample.ch0, f.sim.counts(0x10, false));
+  CHECK_EQ(sample.control, 0x10);
+
+  // Three interrupts before the main loop got round to it: one sample
+  runIsr(f.sim, tsl, 100);
+  tsl.handleInterrupt();
+  tsl.handleInterrupt();
+  CHECK(tsl.serviceInterrupt());
+  CHECK(!tsl.serviceInterrupt());
+  CHECK_EQ(queue.available(), 3);
+  CHECK_EQ(queue.dropped(), 2);
+
+  tsl.stopDataReadyInterrupt();
+  CHECK_EQ(f.sim.peek(0x00) & 0x03, 0);
+}
+
+/// Counts handleInterrupt() calls by servicing each one as it comes
+static uint32_t serviceFor(TSL2591Sim &sim, Adafruit_TSL2591 &tsl,
+                           uint32_t ms) {
+  uint32_t serviced = 0;
+  for (uint32_t i = 0; i < ms; i += 10) {
+    runIsr(sim, tsl, 10);
+    serviced += tsl.serviceInterrupt();
+  }
+  return serviced;
+}
+
+/// The window follows the light, keeps quiet while saturated and leaves
+/// the caller's no-persist thresholds as they were
+static void testTracking(void) {
+  HostFixture f;
+  f.sim.setLight(100, 20);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_LOW);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+  tsl.registerInterrupt(0, 0, 100, 200, TSL2591_PERSIST_ANY);
+  tsl.startTrackingInterrupt(20, TSL2591_PERSIST_ANY);
+
+  // Window 80..120 around the reading, the NP window opened fully
+  CHECK_EQ(f.sim.peek(0x05) << 8 | f.sim.peek(0x04), 80);
+  CHECK_EQ(f.sim.peek(0x07) << 8 | f.sim.peek(0x06), 120);
+  CHECK_EQ(f.sim.peek(0x0B) << 8 | f.sim.peek(0x0A), 0xFFFF);
+  CHECK_EQ(serviceFor(f.sim, tsl, 500), 0);
+
+  // A step in the light fires once, then the window follows it
+  f.sim.setLight(300, 20);
+  CHECK_EQ(serviceFor(f.sim, tsl, 500), 1);
+  CHECK_EQ(f.sim.peek(0x05) << 8 | f.sim.peek(0x04), 240);
+
+  // Saturated: one interrupt on the way in, none while it lasts
+  f.sim.setLight(50000, 20);
+  CHECK_EQ(serviceFor(f.sim, tsl, 1000), 1);
+  CHECK_EQ(f.sim.peek(0x07) << 8 | f.sim.peek(0x06), 0xFFFF);
+  // And one on the way out
+  f.sim.setLight(300, 20);
+  CHECK_EQ(serviceFor(f.sim, tsl, 500), 1);
+  CHECK_EQ(f.sim.peek(0x07) << 8 | f.sim.peek(0x06), 360);
+
+  tsl.stopDataReadyInterrupt();
+  CHECK_EQ(f.sim.peek(0x09) << 8 | f.sim.peek(0x08), 100);
+  CHECK_EQ(f.sim.peek(0x0B) << 8 | f.sim.peek(0x0A), 200);
+}
+
+/// Stopping tracking puts back every threshold and the persist filter
+static void testTrackingRestore(void) {
+  const uint8_t expect[9] = {100 & 0xFF, 100 >> 8,  2000 & 0xFF,
+                             2000 >> 8,  300 & 0xFF, 300 >> 8,
+                             4000 & 0xFF, 4000 >> 8, TSL2591_PERSIST_10};
+  for (uint8_t stop = 0; stop < 3; stop++) {
+    HostFixture f;
+    f.sim.setLight(25000, 20);
+    Adafruit_TSL2591 tsl;
+    CHECK(tsl.begin());
+    tsl.setGain(TSL2591_GAIN_LOW);
+    tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+    tsl.registerInterrupt(100, 2000, 300, 4000, TSL2591_PERSIST_10);
+    if (stop == 2) {
+      // Continuous mode already holds the caller's filter
+      tsl.startContinuous();
+    }
+    tsl.startTrackingInterrupt(10, TSL2591_PERSIST_ANY);
+    CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_ANY);
+    f.sim.setLight(10000, 20);
+    CHECK_EQ(serviceFor(f.sim, tsl, 500), 1);
+
+    if (stop == 1) {
+      tsl.disable();
+    } else {
+      tsl.stopDataReadyInterrupt();
+    }
+    for (uint8_t n = 0; n < 9; n++) {
+      CHECK_EQ(f.sim.peek(0x04 + n), expect[n]);
+    }
+    CHECK_EQ(f.sim.peek(0x00), 0);
+  }
+}
+
+int main(void) {
+  testDataReady();
+  testTracking();
+  testTrackingRestore();
+  return hostTestResult("test_interrupt");
+}
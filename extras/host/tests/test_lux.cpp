@@ -0,0 +1,181 @@
+/**************************************************************************/
+/*!
+    @file     test_lux.cpp
+
+    Checks the integer lux formulas, and the float results scaled from them,
+    against the float formulas they replace at every gain and integration
+    time
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "Adafruit_TSL2591_Fixed.h"
+#include "host_test.h"
+
+/// Analog gain of each setting, as the float calculateLux() used
+static double luxGain(tsl2591Gain_t gain) {
+  switch (gain) {
+  case TSL2591_GAIN_MED:
+    return 25.0;
+  case TSL2591_GAIN_HIGH:
+    return 428.0;
+  case TSL2591_GAIN_MAX:
+    return 9876.0;
+  default:
+    return 1.0;
+  }
+}
+
+/// Float reference in milli-lux, infinite where ALT1 divides by zero
+static double luxReference(uint8_t algorithm, uint16_t ch0, uint16_t ch1,
+                           double cpl) {
+  double a = ch0, b = ch1, lux;
+  if (algorithm == TSL2591_LUX_AMS) {
+    double lux1 = (a - TSL2591_LUX_COEFB * b) / cpl;
+    double lux2 = (TSL2591_LUX_COEFC * a - TSL2591_LUX_COEFD * b) / cpl;
+    lux = (lux1 > lux2) ? lux1 : lux2;
+  } else if (algorithm == TSL2591_LUX_ALT2) {
+    lux = (a - TSL2591_LUX_COEFE * b) / cpl;
+  } else {
+    lux = (a - b) * (1.0 - b / a) / cpl;
+  }
+  lux *= 1000;
+  if (!(lux > 0)) {
+    return 0; // Negative, or NaN in the dark for ALT1
+  }
+  return lux;
+}
+
+/// Counts checked on each channel: the low end densely, then a coarse grid
+static uint32_t luxCounts(uint32_t i) {
+  return (i < 64) ? i : (i - 63) * 997;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compares one formula at one setting over the count grid
+    @param  algorithm TSL2591_LUX_ALGORITHM value
+    @param  gain Gain
+    @param  integration Integration time
+    @param  lux Formula under test, milli-lux or lux
+    @param  scale Results per milli-lux, 1 for milli-lux or 0.001 for lux
+*/
+/**************************************************************************/
+template <typename T>
+static void checkFormula(uint8_t algorithm, tsl2591Gain_t gain,
+                         tsl2591IntegrationTime_t integration,
+                         T (*lux)(uint16_t, uint16_t), double scale = 1) {
+  double cpl = (integration + 1) * 100.0 * luxGain(gain) / TSL2591_LUX_DF;
+  uint16_t limit = Adafruit_TSL2591::saturationLimit(integration);
+  // Q16 coefficients are within half an LSB, AMS has two per term
+  double coefficient = (algorithm == TSL2591_LUX_ALT1) ? 0 : 1.0 / 65536;
+  uint32_t failures = 0;
+
+  for (uint16_t i = 0; luxCounts(i) < limit; i++) {
+    for (uint16_t j = 0; luxCounts(j) < limit; j++) {
+      uint16_t ch0 = luxCounts(i), ch1 = luxCounts(j);
+      double expect = luxReference(algorithm, ch0, ch1, cpl);
+      if ((scale == 1) ? (expect > 0x7FFFFFFF) : isinf(expect)) {
+        expect = 0x7FFFFFFF; // Saturated
+      }
+      double got = lux(ch0, ch1) / scale;
+      // Documented bound: 0.012%, plus coefficient rounding and the Q16
+      // LSB, plus rounding to milli-lux or to float
+      double bound = expect * 1.2e-4 +
+                     ((ch0 + ch1) * coefficient + 1.0 / 65536) * 1000 / cpl +
+                     ((scale == 1) ? 1 : expect * 1e-6);
+      if ((got < 0) || (fabs(got - expect) > bound)) {
+        if (!failures++) {
+          printf("algorithm %u gain 0x%02X integration %u ch0 %u ch1 %u: "
+                 "%.4f, expected %.4f\n",
+                 algorithm, gain, integration, ch0, ch1, got, expect);
+        }
+      }
+    }
+  }
+  CHECK_EQ(failures, 0);
+}
+
+/// Each formula through the compile time driver at one setting
+template <tsl2591Gain_t G, tsl2591IntegrationTime_t I>
+static void checkSetting(void) {
+  checkFormula(
+      TSL2591_LUX_AMS, G, I,
+      Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_AMS>::calculateLuxMilli);
+  checkFormula(
+      TSL2591_LUX_ALT1, G, I,
+      Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_ALT1>::calculateLuxMilli);
+  checkFormula(
+      TSL2591_LUX_ALT2, G, I,
+      Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_ALT2>::calculateLuxMilli);
+  checkFormula(TSL2591_LUX_AMS, G, I,
+               Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_AMS>::calculateLux,
+               0.001);
+  checkFormula(TSL2591_LUX_ALT1, G, I,
+               Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_ALT1>::calculateLux,
+               0.001);
+  checkFormula(TSL2591_LUX_ALT2, G, I,
+               Adafruit_TSL2591_Fixed<G, I, TSL2591_LUX_ALT2>::calculateLux,
+               0.001);
+}
+
+/// Every gain at one integration time
+template <tsl2591IntegrationTime_t I> static void checkIntegration(void) {
+  checkSetting<TSL2591_GAIN_LOW, I>();
+  checkSetting<TSL2591_GAIN_MED, I>();
+  checkSetting<TSL2591_GAIN_HIGH, I>();
+  checkSetting<TSL2591_GAIN_MAX, I>();
+}
+
+/// IR above full spectrum keeps the float formula's positive result
+static void testAlt1Inversion(void) {
+  uint32_t k = Adafruit_TSL2591::luxFactor(TSL2591_GAIN_MED,
+                                           TSL2591_INTEGRATIONTIME_100MS);
+  double cpl = 100.0 * 25.0 / TSL2591_LUX_DF;
+  // (1000 - 1200)^2 / 1000 = 40 counts
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(1000, 1200, k),
+           (int32_t)(40 * 1000 / cpl + 0.5));
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(500, 500, k), 0);
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(0, 0, k), 0);
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(0, 10, k), 0x7FFFFFFF);
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(1, 30000, k), 0x7FFFFFFF);
+
+  // Oversampled sums give the same as one conversion of their mean
+  tsl2591Oversample_t sums = {4000, 4800, 4, 0x10, false};
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(&sums, 1.0F),
+           Adafruit_TSL2591::calculateLuxMilli(1000, 1200, k));
+  sums.ch0 = 0;
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(&sums, 1.0F), 0x7FFFFFFF);
+  sums.ch0 = 1;
+  sums.ch1 = 255UL * 37887;
+  sums.count = 255;
+  CHECK_EQ(Adafruit_TSL2591::calculateLuxMilli(&sums, 1.0F), 0x7FFFFFFF);
+}
+
+/// Low light keeps its resolution in lux, below one milli-lux
+static void testLowLight(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MAX);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_600MS);
+  double cpl = 600.0 * 9876.0 / TSL2591_LUX_DF;
+  // (10 - 2)^2 / 10 = 6.4 counts, (100 - 20)^2 / 100 = 64 counts
+  CHECK(fabs(tsl.calculateLux(10, 2) - 6.4 / cpl) < 6.4 / cpl * 1.2e-4);
+  CHECK(fabs(tsl.calculateLux(100, 20) - 64 / cpl) < 64 / cpl * 1.2e-4);
+  CHECK_EQ(tsl.calculateLux(0, 0), 0);
+  CHECK(tsl.calculateLux(0xFFFF, 0) < 0);
+  CHECK_EQ(tsl.calculateLux(0, 10), 0x7FFFFFFF / 1000.0F);
+}
+
+int main(void) {
+  checkIntegration<TSL2591_INTEGRATIONTIME_100MS>();
+  checkIntegration<TSL2591_INTEGRATIONTIME_200MS>();
+  checkIntegration<TSL2591_INTEGRATIONTIME_300MS>();
+  checkIntegration<TSL2591_INTEGRATIONTIME_400MS>();
+  checkIntegration<TSL2591_INTEGRATIONTIME_500MS>();
+  checkIntegration<TSL2591_INTEGRATIONTIME_600MS>();
+  testAlt1Inversion();
+  testLowLight();
+  return hostTestResult("test_lux");
+}
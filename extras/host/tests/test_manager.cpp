@@ -0,0 +1,158 @@
+/**************************************************************************/
+/*!
+    @file     test_manager.cpp
+
+    Checks the sensor manager against simulated sensors behind a simulated
+    TCA9548A mux
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591_Manager.h"
+#include "host_test.h"
+
+#define SENSORS (3) ///< Sensors on mux channels 0..2
+
+/// Sensors on a mux, each already started with begin()
+struct MuxFixture {
+  TCA9548ASim mux;                  ///< The mux
+  TSL2591Sim sim[SENSORS];          ///< The sensors
+  Adafruit_TSL2591 tsl[SENSORS];    ///< Their drivers
+  Adafruit_TSL2591_Manager manager; ///< Manager of the drivers
+
+  MuxFixture(void) {
+    hostResetClock();
+    Wire.attach(&mux);
+    manager.setMux(&Wire);
+    for (uint8_t i = 0; i < SENSORS; i++) {
+      mux.attach(i, &sim[i]);
+      sim[i].setLight(10 * (i + 1), 2 * (i + 1));
+      selectChannel(i);
+      CHECK(tsl[i].begin());
+      tsl[i].setGain(TSL2591_GAIN_MED);
+      tsl[i].setTiming(TSL2591_INTEGRATIONTIME_100MS);
+      CHECK(manager.add(&tsl[i], i));
+    }
+  }
+  ~MuxFixture(void) { Wire.detach(&mux); }
+
+  void selectChannel(uint8_t channel) {
+    Wire.beginTransmission(TSL2591_TCA9548A_ADDR);
+    Wire.write(1 << channel);
+    Wire.endTransmission();
+  }
+};
+
+/// Mux channels only go up to 7
+static void testAdd(void) {
+  Adafruit_TSL2591_Manager manager;
+  Adafruit_TSL2591 tsl;
+  CHECK(!manager.add(&tsl, 8));
+  CHECK(!manager.add(&tsl, 0xFE));
+  CHECK_EQ(manager.count(), 0);
+  CHECK(manager.add(&tsl, 7));
+  CHECK(manager.add(&tsl, TSL2591_NO_MUX));
+  CHECK_EQ(manager.count(), 2);
+}
+
+/// All sensors convert together, so the group costs one integration
+static void testReadAll(void) {
+  MuxFixture f;
+  uint32_t start = millis();
+  f.manager.readAll();
+  CHECK(millis() - start < 120);
+
+  for (uint8_t i = 0; i < SENSORS; i++) {
+    uint32_t lum = f.manager.getFullLuminosity(i);
+    CHECK_EQ(lum & 0xFFFF, f.sim[i].counts(0x10, false));
+    CHECK_EQ(lum >> 16, f.sim[i].counts(0x10, true));
+    CHECK(!f.manager.isStale(i));
+    CHECK(f.manager.getLux(i) > 0);
+  }
+  CHECK(f.manager.isStale(SENSORS));
+}
+
+/// A sensor that misses the worst case time is read anyway, and flagged
+static void testStale(void) {
+  MuxFixture f;
+  f.sim[1].setStepTime(150000);
+  f.manager.readAll();
+
+  CHECK(!f.manager.isStale(0));
+  CHECK(f.manager.isStale(1));
+  CHECK(!f.manager.isStale(2));
+
+  // Back on time, the flag clears with the next good reading
+  f.sim[1].setStepTime(TSL2591_SIM_STEP_US);
+  f.manager.readAll();
+  CHECK(!f.manager.isStale(1));
+  CHECK_EQ(f.manager.getFullLuminosity(1) & 0xFFFF,
+           f.sim[1].counts(0x10, false));
+}
+
+/// A read that fails keeps the previous reading, flagged stale
+static void testFailedRead(void) {
+  MuxFixture f;
+  f.manager.readAll();
+  uint32_t before = f.manager.getFullLuminosity(2);
+
+  f.sim[2].setLight(50, 10);
+  f.sim[2].failNext(1000);
+  f.manager.readAll();
+  CHECK(!f.manager.isStale(0));
+  CHECK(f.manager.isStale(2));
+  CHECK_EQ(f.manager.getFullLuminosity(2), before);
+  f.sim[2].failNext(0);
+}
+
+/// A mux write that fails is not trusted, the next access writes it again
+static void testMuxFailure(void) {
+  MuxFixture f; // Left with channel 2 selected
+  Adafruit_TSL2591_Manager manager;
+  manager.setMux(&Wire);
+  CHECK(manager.add(&f.tsl[0], 0));
+
+  f.mux.failNext(1);
+  manager.readAll();
+  CHECK_EQ(f.mux.control(), 1);
+  manager.readAll();
+  CHECK(!manager.isStale(0));
+  CHECK_EQ(manager.getFullLuminosity(0) & 0xFFFF,
+           f.sim[0].counts(0x10, false));
+}
+
+/// A sensor on the main bus is reached with every mux channel off
+static void testNoMux(void) {
+  MuxFixture f;
+  TSL2591Sim direct; // Same address as the sensors behind the mux
+  direct.setLight(70, 7);
+  Wire.attach(&direct);
+  Wire.beginTransmission(TSL2591_TCA9548A_ADDR);
+  Wire.write(0); // All channels off
+  Wire.endTransmission();
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+  CHECK(f.manager.add(&tsl, TSL2591_NO_MUX));
+
+  f.manager.readAll();
+  CHECK_EQ(f.mux.control(), 0);
+  for (uint8_t i = 0; i < SENSORS; i++) {
+    CHECK_EQ(f.manager.getFullLuminosity(i) & 0xFFFF,
+             f.sim[i].counts(0x10, false));
+  }
+  CHECK(!f.manager.isStale(SENSORS));
+  CHECK_EQ(f.manager.getFullLuminosity(SENSORS) & 0xFFFF,
+           direct.counts(0x10, false));
+  Wire.detach(&direct);
+}
+
+int main(void) {
+  testAdd();
+  testReadAll();
+  testStale();
+  testFailedRead();
+  testMuxFailure();
+  testNoMux();
+  return hostTestResult("test_manager");
+}
@@ -0,0 +1,183 @@
+/**************************************************************************/
+/*!
+    @file     test_resume.cpp
+
+    Checks resume() with verify, and verifyState(), against a simulated
+    sensor that was reset or replaced while the MCU slept
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "host_test.h"
+
+/// A reset chip fails the first reading, then reads with our settings again
+static void testResetOneShot(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_HIGH);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_200MS);
+  tsl2591State_t state;
+  CHECK(tsl.exportState(&state));
+
+  f.sim.powerOnReset();
+  Adafruit_TSL2591 woken;
+  CHECK(woken.resume(&state, &Wire, true));
+  uint32_t lum = 1;
+  CHECK_EQ(woken.readFullLuminosity(&lum), TSL2591_ERR_RESET);
+  CHECK_EQ(lum, 0);
+  CHECK_EQ(f.sim.peek(0x01), 0x21);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+
+  CHECK_EQ(woken.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x21, false));
+}
+
+/// A different part is powered down and reported as not found
+static void testReplaced(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl2591State_t state;
+  CHECK(tsl.exportState(&state));
+
+  f.sim.setId(0x51);
+  Adafruit_TSL2591 woken;
+  CHECK(woken.resume(&state, &Wire, true));
+  CHECK(f.sim.peek(0x00) & 0x02); // resume() started a conversion
+  uint32_t lum = 1;
+  CHECK_EQ(woken.readResult(&lum), TSL2591_ERR_NOT_FOUND);
+  CHECK_EQ(lum, 0);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+}
+
+/// After a reset in interrupt mode no zero sample reaches the queue
+static void testResetInterrupt(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  Adafruit_TSL2591_SampleFifo<8> queue;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+  tsl.startDataReadyInterrupt(&queue);
+  tsl2591State_t state;
+  CHECK(tsl.exportState(&state));
+
+  delay(150);
+  f.sim.powerOnReset();
+  CHECK(tsl.resume(&state, &Wire, true));
+  tsl.handleInterrupt();
+  CHECK(!tsl.serviceInterrupt());
+  CHECK_EQ(queue.available(), 0);
+  CHECK_EQ(queue.dropped(), 1);
+
+  // The restored settings convert again
+  delay(110);
+  CHECK(f.sim.interrupt());
+  tsl.handleInterrupt();
+  CHECK(tsl.serviceInterrupt());
+  tsl2591Sample_t sample;
+  CHECK(queue.pop(&sample));
+  CHECK_EQ(sample.ch0, f.sim.counts(0x10, false));
+}
+
+/// After a reset while oversampling the sums only hold real conversions
+static void testResetOversampling(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_MED);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_100MS);
+  tsl.startOversampling(4);
+  tsl2591State_t state;
+  CHECK(tsl.exportState(&state));
+
+  f.sim.powerOnReset();
+  CHECK(tsl.resume(&state, &Wire, true));
+  tsl2591Oversample_t sums;
+  CHECK_EQ(tsl.readOversampled(4, &sums), TSL2591_OK);
+  CHECK_EQ(sums.count, 4);
+  CHECK_EQ(sums.ch0, 4 * f.sim.counts(0x10, false));
+  CHECK_EQ(sums.ch1, 4 * f.sim.counts(0x10, true));
+}
+
+/// verifyState() keeps the intended settings, restoreState() writes them
+static void testVerifyRestore(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_HIGH);
+  tsl.registerInterrupt(100, 2000, TSL2591_PERSIST_5);
+  CHECK_EQ(tsl.verifyState(), TSL2591_OK);
+
+  f.sim.powerOnReset();
+  tsl2591Snapshot_t snapshot;
+  CHECK_EQ(tsl.verifyState(&snapshot), TSL2591_ERR_RESET);
+  CHECK_EQ(snapshot.persist, 0);
+  tsl2591State_t state;
+  CHECK(!tsl.exportState(&state));
+
+  Wire.log.clear();
+  Wire.recording = true;
+  CHECK_EQ(tsl.restoreState(), TSL2591_OK);
+  Wire.recording = false;
+  CHECK_EQ(Wire.log.size(), 1); // One block write, ENABLE was not lost
+  CHECK_EQ(f.sim.peek(0x01), 0x20);
+  CHECK_EQ(f.sim.peek(0x05) << 8 | f.sim.peek(0x04), 100);
+  CHECK_EQ(f.sim.peek(0x07) << 8 | f.sim.peek(0x06), 2000);
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_5);
+  CHECK_EQ(tsl.verifyState(), TSL2591_OK);
+  CHECK(tsl.exportState(&state));
+
+  // A different part leaves nothing in the snapshot
+  f.sim.setId(0x51);
+  CHECK_EQ(tsl.readSnapshot(&snapshot), TSL2591_ERR_NOT_FOUND);
+  CHECK_EQ(snapshot.control, 0);
+  CHECK_EQ(snapshot.upperThreshold, 0);
+}
+
+/// begin(config) after a reset programs the config, not continuous mode's
+static void testBeginAfterReset(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.startContinuous();
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_EVERY);
+
+  f.sim.powerOnReset();
+  tsl2591Config_t cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.gain = TSL2591_GAIN_HIGH;
+  cfg.integration = TSL2591_INTEGRATIONTIME_200MS;
+  cfg.persist = TSL2591_PERSIST_10;
+  cfg.lowerThreshold = 100;
+  cfg.upperThreshold = 2000;
+  cfg.npUpperThreshold = 0xFFFF;
+  cfg.power = TSL2591_POWER_OFF;
+  CHECK(tsl.begin(&cfg));
+  CHECK(!tsl.isContinuous());
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_10);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+  CHECK_EQ(f.sim.peek(0x01), 0x21);
+
+  // And continuous again hands the same filter back when it stops
+  cfg.power = TSL2591_POWER_CONTINUOUS;
+  f.sim.powerOnReset();
+  CHECK(tsl.begin(&cfg));
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_EVERY);
+  tsl.stopContinuous();
+  CHECK_EQ(f.sim.peek(0x0C), TSL2591_PERSIST_10);
+}
+
+int main(void) {
+  testResetOneShot();
+  testReplaced();
+  testResetInterrupt();
+  testResetOversampling();
+  testVerifyRestore();
+  testBeginAfterReset();
+  return hostTestResult("test_resume");
+}
@@ -0,0 +1,127 @@
+/**************************************************************************/
+/*!
+    @file     test_samples.cpp
+
+    Checks the sample ring statistics and the sample queue
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591_Samples.h"
+#include "host_test.h"
+
+static tsl2591Sample_t sample = {0, 0, 0, 0}; ///< Contents do not matter
+
+/// Statistics cover every sample since clear(), also once it is overwritten
+static void testSinceClear(void) {
+  Adafruit_TSL2591_SampleRing<4> ring;
+  CHECK_EQ(ring.meanLux(), 0);
+
+  int32_t lux[6] = {5000, 1000, 9000, 3000, 4000, 2000};
+  for (uint8_t i = 0; i < 4; i++) {
+    ring.push(&sample, lux[i]);
+  }
+  CHECK_EQ(ring.count(), 4);
+  CHECK_EQ(ring.minLux(), 1000);
+  CHECK_EQ(ring.maxLux(), 9000);
+  CHECK_EQ(ring.meanLux(), 4500);
+
+  // 5000 and 1000 are overwritten but still counted
+  ring.push(&sample, lux[4]);
+  ring.push(&sample, lux[5]);
+  CHECK_EQ(ring.size(), 4);
+  CHECK_EQ(ring.count(), 6);
+  CHECK_EQ(ring.minLux(), 1000);
+  CHECK_EQ(ring.maxLux(), 9000);
+  CHECK_EQ(ring.meanLux(), 4000);
+
+  // Overflows take a slot but stay out of the lux statistics
+  ring.push(&sample, -1);
+  ring.push(&sample, -1);
+  CHECK_EQ(ring.count(), 6);
+  CHECK_EQ(ring.overflows(), 2);
+  CHECK_EQ(ring.meanLux(), 4000);
+
+  ring.clear();
+  CHECK_EQ(ring.size(), 0);
+  CHECK_EQ(ring.count(), 0);
+  CHECK_EQ(ring.overflows(), 0);
+  CHECK_EQ(ring.minLux(), 0);
+  CHECK_EQ(ring.maxLux(), 0);
+  CHECK_EQ(ring.meanLux(), 0);
+}
+
+/// Past 65535 samples the mean switches to one 64 bit division
+static void testLongRun(void) {
+  Adafruit_TSL2591_SampleRing<8> ring;
+  for (uint32_t i = 0; i < 70000; i++) {
+    ring.push(&sample, (i & 1) ? 0x7FFFFFFF : 0x7FFFFFFD);
+  }
+  CHECK_EQ(ring.count(), 70000);
+  CHECK_EQ(ring.minLux(), 0x7FFFFFFD);
+  CHECK_EQ(ring.maxLux(), 0x7FFFFFFF);
+  CHECK_EQ(ring.meanLux(), 0x7FFFFFFE);
+}
+
+/// The mean stays exact with the largest values
+static void testMeanRange(void) {
+  static Adafruit_TSL2591_SampleRing<1000> ring;
+  int64_t sum = 0;
+  for (uint16_t i = 0; i < 1000; i++) {
+    int32_t lux = 0x7FFFFFFF - i * 7919;
+    ring.push(&sample, lux);
+    sum += lux;
+  }
+  CHECK_EQ(ring.meanLux(), sum / 1000);
+}
+
+/// The EMA settles on a steady input instead of stopping short of it
+static void testEma(void) {
+  Adafruit_TSL2591_SampleRing<2> ring;
+  ring.push(&sample, 0);
+  for (uint16_t i = 0; i < 200; i++) {
+    ring.push(&sample, 1003);
+  }
+  CHECK_EQ(ring.emaLux(), 1003);
+
+  // Coming down from above too
+  for (uint16_t i = 0; i < 200; i++) {
+    ring.push(&sample, 20);
+  }
+  CHECK_EQ(ring.emaLux(), 20);
+
+  // One step of 1/8
+  ring.push(&sample, 820);
+  CHECK_EQ(ring.emaLux(), 120);
+
+  // A new shift keeps the current average
+  ring.setEmaShift(0);
+  CHECK_EQ(ring.emaLux(), 120);
+  ring.push(&sample, 77);
+  CHECK_EQ(ring.emaLux(), 77);
+}
+
+/// The queue hands samples over in order and counts what did not fit
+static void testQueue(void) {
+  Adafruit_TSL2591_SampleFifo<2> queue;
+  tsl2591Sample_t in = {0, 0, 0, 0}, out;
+  for (uint8_t i = 0; i < 3; i++) {
+    in.ch0 = i;
+    CHECK_EQ(queue.push(&in), i < 2);
+  }
+  CHECK_EQ(queue.available(), 2);
+  CHECK_EQ(queue.dropped(), 1);
+  CHECK(queue.pop(&out));
+  CHECK_EQ(out.ch0, 0);
+  CHECK(queue.pop(&out));
+  CHECK_EQ(out.ch0, 1);
+  CHECK(!queue.pop(&out));
+}
+
+int main(void) {
+  testSinceClear();
+  testLongRun();
+  testMeanRange();
+  testEma();
+  testQueue();
+  return hostTestResult("test_samples");
+}
@@ -0,0 +1,220 @@
+/**************************************************************************/
+/*!
+    @file     test_sim.cpp
+
+    Checks the simulated TSL2591 itself, and that the driver's bus traffic
+    reaches the bus monitor in full
+*/
+/**************************************************************************/
+
+#include "Adafruit_TSL2591.h"
+#include "Adafruit_TSL2591_Fixed.h"
+#include "host_test.h"
+
+#include <vector>
+
+/// Transactions reported to the bus monitor
+static std::vector<tsl2591Transaction_t> monitored;
+
+static void monitor(const tsl2591Transaction_t *t, void *context) {
+  (void)context;
+  monitored.push_back(*t);
+}
+
+/// Writes registers from reg on, as the driver would
+static void writeRegs(uint8_t reg, const uint8_t *data, size_t len) {
+  Wire.beginTransmission(0x29);
+  Wire.write(0xA0 | reg);
+  Wire.write(data, len);
+  Wire.endTransmission();
+}
+
+/// AVALID, channel data and the ALS interrupt follow the integration cycle
+static void testCycleTiming(void) {
+  HostFixture f;
+  f.sim.setLight(100, 20);
+
+  // 200ms at medium gain, then PON | AEN | AIEN. A cycle takes the CONTROL
+  // settings it started with
+  uint8_t control = 0x11;
+  writeRegs(0x01, &control, 1);
+  uint8_t enable = 0x13;
+  writeRegs(0x00, &enable, 1);
+
+  delay(199);
+  CHECK_EQ(f.sim.peek(0x13) & 0x01, 0);
+  CHECK_EQ(f.sim.cycles(), 0);
+  delay(1);
+  // AVALID, AINT at PERSIST_EVERY and NPINTR for the power-on NP window
+  CHECK_EQ(f.sim.peek(0x13), 0x31);
+  CHECK_EQ(f.sim.peek(0x15) << 8 | f.sim.peek(0x14), 100 * 25 * 2);
+  CHECK_EQ(f.sim.peek(0x17) << 8 | f.sim.peek(0x16), 20 * 25 * 2);
+  CHECK(f.sim.interrupt());
+
+  // Clear ALS interrupt only, then a slower oscillator
+  Wire.beginTransmission(0x29);
+  Wire.write(0xE6);
+  Wire.endTransmission();
+  CHECK_EQ(f.sim.peek(0x13), 0x21);
+  f.sim.setStepTime(110000);
+  delay(219); // The running cycle started at the old step time
+  CHECK_EQ(f.sim.cycles(), 2);
+  delay(220);
+  CHECK_EQ(f.sim.cycles(), 3);
+
+  // A persist filter only flags readings outside the window
+  uint8_t window[9] = {0, 0, 0xFF, 0xFF, 0, 0, 0xFF, 0xFF, 0x01};
+  writeRegs(0x04, window, 9);
+  Wire.beginTransmission(0x29);
+  Wire.write(0xE7);
+  Wire.endTransmission();
+  delay(440);
+  CHECK_EQ(f.sim.peek(0x13), 0x01);
+  CHECK(!f.sim.interrupt());
+
+  // Analog saturation at 100ms
+  control = 0x30;
+  writeRegs(0x01, &control, 1);
+  delay(440);
+  CHECK_EQ(f.sim.peek(0x15) << 8 | f.sim.peek(0x14), 37888);
+  CHECK_EQ(f.sim.peek(0x13) & 0x20, 0); // Inside the NP window
+}
+
+/// A brown-out puts the power-on values back
+static void testReset(void) {
+  HostFixture f;
+  uint8_t setup[2] = {0x03, 0x25};
+  writeRegs(0x00, setup, 2);
+  CHECK_EQ(f.sim.peek(0x01), 0x25);
+  f.sim.powerOnReset();
+  CHECK_EQ(f.sim.peek(0x00), 0);
+  CHECK_EQ(f.sim.peek(0x01), 0);
+  CHECK_EQ(f.sim.peek(0x12), 0x50);
+
+  // Software reset through CONTROL
+  writeRegs(0x00, setup, 2);
+  uint8_t reset = 0x80;
+  writeRegs(0x01, &reset, 1);
+  CHECK_EQ(f.sim.peek(0x01), 0);
+}
+
+/// begin() reports every transaction, the address probe included
+static void testBeginMonitored(void) {
+  HostFixture f;
+  Adafruit_TSL2591 tsl;
+  tsl.setBusMonitor(monitor);
+  monitored.clear();
+  Wire.transactions = 0;
+
+  CHECK(tsl.begin());
+  CHECK(monitored.size() >= 2);
+  // A register read is a write and a read on the wire
+  uint32_t onWire = 0;
+  for (size_t i = 0; i < monitored.size(); i++) {
+    onWire += monitored[i].read ? 2 : 1;
+  }
+  CHECK_EQ(onWire, Wire.transactions);
+  CHECK_EQ(monitored[0].command, TSL2591_ADDRESS_PROBE);
+  CHECK_EQ(monitored[0].written, 0);
+  CHECK_EQ(monitored[0].read, 0);
+  CHECK(monitored[0].ok);
+  CHECK(monitored[0].duration > 0);
+
+  // A sensor that does not answer costs just the reported probe
+  f.sim.failNext(1);
+  monitored.clear();
+  Wire.transactions = 0;
+  CHECK(!tsl.begin());
+  CHECK_EQ(monitored.size(), 1);
+  CHECK_EQ(Wire.transactions, 1);
+  CHECK(!monitored[0].ok);
+}
+
+/// A blocking read against the model returns what the model converted
+static void testRead(void) {
+  HostFixture f;
+  f.sim.setLight(2, 0.5);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setGain(TSL2591_GAIN_HIGH);
+  tsl.setTiming(TSL2591_INTEGRATIONTIME_300MS);
+
+  uint32_t start = millis();
+  uint32_t lum;
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x22, false));
+  CHECK_EQ(lum >> 16, f.sim.counts(0x22, true));
+  CHECK(millis() - start >= 300);
+  CHECK(millis() - start < 310);
+  CHECK_EQ(f.sim.peek(0x00), 0); // Powered down again
+}
+
+/// A conversion that overruns the worst case time still makes an event
+static void testEventTimeout(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591 tsl;
+  CHECK(tsl.begin());
+  tsl.setSettlePolicy(TSL2591_SETTLE_SINGLE);
+  f.sim.setStepTime(130000);
+
+  uint32_t lum;
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_ERR_TIMEOUT);
+  sensors_event_t event;
+  CHECK(tsl.getEvent(&event));
+  CHECK_EQ(event.type, SENSOR_TYPE_LIGHT);
+
+  // No sensor is still a failure
+  f.sim.failNext(1000);
+  CHECK(!tsl.getEvent(&event));
+  f.sim.failNext(0);
+}
+
+/// The fixed settings driver powers down and reports on every exit path
+static void testFixed(void) {
+  HostFixture f;
+  f.sim.setLight(10, 2);
+  Adafruit_TSL2591_Fixed<TSL2591_GAIN_MED, TSL2591_INTEGRATIONTIME_100MS> tsl;
+  CHECK(tsl.begin());
+
+  uint32_t lum = 1;
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_OK);
+  CHECK_EQ(lum & 0xFFFF, f.sim.counts(0x10, false));
+  CHECK_EQ(lum >> 16, f.sim.counts(0x10, true));
+  CHECK_EQ(f.sim.peek(0x00), 0);
+
+  // A conversion that overruns the poll window
+  f.sim.setStepTime(130000);
+  lum = 1;
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_ERR_TIMEOUT);
+  CHECK_EQ(lum, 0);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+  f.sim.setStepTime(TSL2591_SIM_STEP_US);
+
+  // The start fails
+  f.sim.failNext(1);
+  CHECK_EQ(tsl.readFullLuminosity(&lum), TSL2591_ERR_BUS);
+  f.sim.failNext(1);
+  CHECK_EQ(tsl.getFullLuminosity(), 0);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+
+  // The channel read fails, the power down still goes out
+  CHECK(tsl.startConversion());
+  delay(110);
+  CHECK(tsl.isReady());
+  f.sim.failNext(1);
+  lum = 1;
+  CHECK_EQ(tsl.readResult(&lum), TSL2591_ERR_BUS);
+  CHECK_EQ(lum, 0);
+  CHECK_EQ(f.sim.peek(0x00), 0);
+}
+
+int main(void) {
+  testCycleTiming();
+  testReset();
+  testBeginMonitored();
+  testRead();
+  testEventTimeout();
+  testFixed();
+  return hostTestResult("test_sim");
+}